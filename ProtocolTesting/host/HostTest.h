@@ -0,0 +1,37 @@
+/*
+ * Minimal check macros shared by the host tests, each test file is its own executable and exits non-zero if
+ * any check failed.
+ */
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <math.h>
+#include <stdio.h>
+
+static int hostTestChecks = 0;
+static int hostTestFailures = 0;
+
+#define CHECK(condition) hostTestCheck((condition) ? 1 : 0, #condition, __FILE__, __LINE__)
+#define CHECK_NEAR(actual, expected, tolerance) hostTestCheck(fabs((double) (actual) - (double) (expected)) <= (tolerance) ? 1 : 0, #actual " ~ " #expected, __FILE__, __LINE__)
+
+static inline void hostTestCheck(int passed, const char * text, const char * file, int line)
+{
+	hostTestChecks++;
+
+	if(!passed)
+	{
+		hostTestFailures++;
+		printf("%s:%d: check failed: %s\n", file, line, text);
+	}
+}
+
+//Run a test function, naming it in the output
+#define RUN_TEST(test) do { int failuresBefore = hostTestFailures; test(); printf("%s %s\n", hostTestFailures == failuresBefore ? "PASS" : "FAIL", #test); } while(0)
+
+static inline int hostTestResult()
+{
+	printf("%d checks, %d failed\n", hostTestChecks, hostTestFailures);
+	return hostTestFailures == 0 ? 0 : 1;
+}
+
+#endif
@@ -0,0 +1,83 @@
+/*
+ * Builds MAVLink v1/v2 frames for the host tests and benchmarks, with a bitwise checksum written separately from
+ * the table free one in the parser so the two check each other.
+ */
+#ifndef MAVLINK_GENERATOR_H
+#define MAVLINK_GENERATOR_H
+
+#include <stdint.h>
+#include <string.h>
+#include "MavlinkParser.h"
+
+//CRC-16/MCRF4XX, reflected polynomial 0x1021
+static inline uint16_t mavlinkGeneratorCrc(const uint8_t * bytes, int length, uint16_t crc)
+{
+	for(int i = 0; i < length; i++)
+	{
+		crc ^= bytes[i];
+
+		for(int bit = 0; bit < 8; bit++)
+			crc = (crc & 1) ? (crc >> 1) ^ 0x8408 : crc >> 1;
+	}
+
+	return crc;
+}
+
+/**
+ * @brief Write one frame into out
+ * 
+ * @param out Buffer of at least MAVLINK_HEADER_V2 + payloadLength + 2 + MAVLINK_SIGNATURE_LENGTH bytes
+ * @param version2 1 for a v2 frame, 0 for v1
+ * @param incompatFlags v2 incompat_flags, a signature is appended when MAVLINK_IFLAG_SIGNED is set
+ * @param sequence The packet sequence number
+ * @param messageId The message id, below 256 for v1
+ * @param crcExtra The CRC_EXTRA seed of the message
+ * @param payload The payload
+ * @param payloadLength The payload length, v2 trailing zero bytes are not trimmed
+ * 
+ * @return The frame length
+ */
+static inline int mavlinkGenerateFrame(uint8_t * out, uint8_t version2, uint8_t incompatFlags, uint8_t sequence,
+	uint32_t messageId, uint8_t crcExtra, const uint8_t * payload, uint8_t payloadLength)
+{
+	int length = 0;
+
+	out[length++] = version2 ? MAVLINK_STX_V2 : MAVLINK_STX_V1;
+	out[length++] = payloadLength;
+
+	if(version2)
+	{
+		out[length++] = incompatFlags;
+		out[length++] = 0;
+	}
+
+	out[length++] = sequence;
+	out[length++] = 255;
+	out[length++] = 190;
+	out[length++] = messageId & 0xFF;
+
+	if(version2)
+	{
+		out[length++] = (messageId >> 8) & 0xFF;
+		out[length++] = (messageId >> 16) & 0xFF;
+	}
+
+	memcpy(&out[length], payload, payloadLength);
+	length += payloadLength;
+
+	uint16_t crc = mavlinkGeneratorCrc(&out[1], length - 1, 0xFFFF);
+	crc = mavlinkGeneratorCrc(&crcExtra, 1, crc);
+	out[length++] = crc & 0xFF;
+	out[length++] = crc >> 8;
+
+	//The parser does not check signatures, any bytes will do
+	if(version2 && (incompatFlags & MAVLINK_IFLAG_SIGNED))
+	{
+		for(int i = 0; i < MAVLINK_SIGNATURE_LENGTH; i++)
+			out[length++] = 0xA0 + i;
+	}
+
+	return length;
+}
+
+#endif
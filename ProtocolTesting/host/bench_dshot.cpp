@@ -0,0 +1,31 @@
+//Cost of turning a throttle percentage into the RMT items of a DShot frame
+#include <stdio.h>
+#include <time.h>
+#include "DShotEncoder.h"
+
+static double wallSeconds()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+int main()
+{
+	const int frames = 20000000;
+	DShotEncoder encoder(600);
+	uint32_t symbols[DSHOT_FRAME_SYMBOLS];
+	uint32_t checksum = 0;
+
+	double startTime = wallSeconds();
+	for(int i = 0; i < frames; i++)
+	{
+		encoder.encode(DShotEncoder::packet(DShotEncoder::throttleValue((i % 1000) * .1f), 0), symbols);
+		checksum += symbols[i % DSHOT_FRAME_BITS];
+	}
+	double elapsed = wallSeconds() - startTime;
+
+	printf("throttle to RMT frame: %.1f ns per frame (checksum %08x)\n", elapsed * 1e9 / frames, checksum);
+
+	return 0;
+}
@@ -0,0 +1,41 @@
+//Throughput of the batched FlightDynamics step in vehicle steps per millisecond
+#include <stdio.h>
+#include <time.h>
+#include "FlightDynamics.h"
+
+static double wallSeconds()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+int main()
+{
+	const int counts[] = { 1, 8, 64, 1024, 16384 };
+
+	//A single vehicle still steps a whole padded block, so its rate shows the cost of one vector pass
+	printf("step kernels work in blocks of %d vehicles\n", DYNAMICS_VECTOR_WIDTH);
+
+	for(unsigned int c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+	{
+		FlightDynamics dynamics(counts[c]);
+
+		for(int i = 0; i < counts[c]; i++)
+		{
+			float values[6] = { 50.f + i % 7, 60, 50.f - i % 5, 50.f + i % 3, 0, 0 };
+			dynamics.setCommand(i, values);
+		}
+
+		//Enough steps for about 50 million vehicle steps at every batch size
+		int steps = 50000000 / counts[c];
+		double startTime = wallSeconds();
+		for(int s = 0; s < steps; s++)
+			dynamics.step(.002f);
+		double elapsed = wallSeconds() - startTime;
+
+		printf("%6d vehicles: %8.0f vehicle steps per ms (altitude check %.2f)\n", counts[c], (double) steps * counts[c] / (elapsed * 1000), dynamics.getAltitude(0));
+	}
+
+	return 0;
+}
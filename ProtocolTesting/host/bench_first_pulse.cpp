@@ -0,0 +1,90 @@
+//Time from power on to the first output pulse, cold and resuming from a snapshot, on the system clock
+//
+//With --trace, boots once from the snapshot and sets the throttle instead, then writes the trace dump to stdout, the
+//dump only has events in the build from make trace
+#include <stdio.h>
+#include <string.h>
+#include "MockDriver.h"
+#include "FlightControlEmulator.h"
+#include "TraceRecorder.h"
+
+#define BENCH_RUNS 2000
+
+class MemorySnapshotStore : public FlightSnapshotStore
+{
+public:
+	FlightSnapshot snapshot;
+
+	MemorySnapshotStore() { this->snapshot.magic = 0; }
+
+	void save(const FlightSnapshot & snapshot) { this->snapshot = snapshot; }
+	uint8_t load(FlightSnapshot & snapshot) { snapshot = this->snapshot; return flightSnapshotValid(&snapshot); }
+	void clear() { this->snapshot.magic = 0; }
+};
+
+//Construct, init and start a controller as setup() would, returning microseconds until the outputs started
+static uint64_t bootToFirstPulse(FlightSnapshotStore * store)
+{
+	mockDriverReset();
+	uint64_t boot = FlightClock::system()->now();
+
+	FlightControlEmulator controller;
+	controller.setSnapshotStore(store);
+	controller.init();
+	controller.start();
+
+	return controller.getFirstStartMicros() - boot;
+}
+
+static void writeTraceLine(const char * line)
+{
+	printf("%s\n", line);
+}
+
+int main(int argc, char ** argv)
+{
+	MemorySnapshotStore store;
+
+	{
+		mockDriverReset();
+		FlightControlEmulator controller;
+		controller.setSnapshotStore(&store);
+		controller.init();
+		controller.start();
+		controller.setThrottle(70);
+	}
+
+	if(argc > 1 && strcmp(argv[1], "--trace") == 0)
+	{
+		TraceRecorder::clear();
+
+		mockDriverReset();
+		FlightControlEmulator controller;
+		controller.setSnapshotStore(&store);
+		controller.init();
+		controller.start();
+		controller.setThrottle(40);
+
+		TraceRecorder::dump(writeTraceLine);
+		return 0;
+	}
+
+	const char * names[2] = { "cold start", "resume" };
+	for(int resume = 0; resume < 2; resume++)
+	{
+		uint64_t total = 0;
+		uint64_t worst = 0;
+
+		for(int run = 0; run < BENCH_RUNS; run++)
+		{
+			uint64_t micros = bootToFirstPulse(resume ? (FlightSnapshotStore *) &store : NULL);
+			total += micros;
+			worst = micros > worst ? micros : worst;
+		}
+
+		printf("%s: boot to first pulse %.2f us mean, %llu us worst, %u driver calls\n", names[resume],
+			(double) total / BENCH_RUNS, (unsigned long long) worst, mockDriverCalls().total);
+	}
+
+	return 0;
+}
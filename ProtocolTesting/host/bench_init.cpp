@@ -0,0 +1,51 @@
+//Driver calls and host time for MCPWM bring-up and start, full, deferred and parallel
+#include <stdio.h>
+#include "MockDriver.h"
+#include "FlightControlEmulator.h"
+
+#define BENCH_RUNS 2000
+
+typedef struct
+{
+	const char * name;
+	uint8_t channelMask;
+	uint8_t parallel;
+} bench_case_t;
+
+int main()
+{
+	const bench_case_t cases[] = {
+		{ "all channels, serial", 0x3F, 0 },
+		{ "all channels, parallel", 0x3F, 1 },
+		{ "throttle only, serial", 0x02, 0 },
+		{ "aileron to rudder, serial", 0x0F, 0 }
+	};
+
+	FlightClock * clock = FlightClock::system();
+
+	for(unsigned int c = 0; c < sizeof(cases) / sizeof(cases[0]); c++)
+	{
+		uint64_t total = 0;
+		uint32_t initCalls = 0;
+		uint32_t startCalls = 0;
+
+		for(int run = 0; run < BENCH_RUNS; run++)
+		{
+			mockDriverReset();
+			FlightControlEmulator controller;
+			controller.setParallelInit(cases[c].parallel);
+
+			uint64_t startTime = clock->now();
+			controller.init(cases[c].channelMask);
+			initCalls = mockDriverCalls().total;
+			controller.start();
+			total += clock->now() - startTime;
+			startCalls = mockDriverCalls().total - initCalls;
+		}
+
+		printf("%-26s init %2u driver calls, start %2u driver calls, init and start %.2f us on the host mock\n",
+			cases[c].name, initCalls, startCalls, (double) total / BENCH_RUNS);
+	}
+
+	return 0;
+}
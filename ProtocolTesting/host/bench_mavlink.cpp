@@ -0,0 +1,165 @@
+//MAVLink commands committed per second from a sender process over loopback UDP, and the parser alone on a
+//generated stream of mixed v1, v2 and signed frames
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sched.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "MockDriver.h"
+#include "MavlinkGenerator.h"
+#include "MavlinkIngest.h"
+
+#define BENCH_DATAGRAMS 100000
+
+static double wallSeconds()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+//Alternate overrides and manual controls in each framing, every one a command for system 1
+static int generateCommand(uint8_t * out, int index)
+{
+	uint8_t payload[MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_LEN];
+
+	for(uint8_t i = 0; i < sizeof(payload); i++)
+		payload[i] = (uint8_t) (index + i);
+
+	if(index % 2)
+	{
+		payload[16] = 1;
+		return mavlinkGenerateFrame(out, index % 3 != 0, index % 5 == 0 ? MAVLINK_IFLAG_SIGNED : 0, index,
+			MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE, MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_CRC, payload, sizeof(payload));
+	}
+
+	payload[10] = 1;
+	return mavlinkGenerateFrame(out, index % 3 != 0, 0, index, MAVLINK_MSG_ID_MANUAL_CONTROL,
+		MAVLINK_MSG_ID_MANUAL_CONTROL_CRC, payload, MAVLINK_MSG_ID_MANUAL_CONTROL_LEN);
+}
+
+static int benchUdp()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	if(controller.init() != FLIGHT_SUCCESS || controller.start() != FLIGHT_SUCCESS)
+		return 1;
+
+	MavlinkIngest ingest(&controller, 1);
+	MavlinkUdpReceiver receiver(&ingest);
+
+	uint16_t port = 0;
+	for(int attempt = 0; attempt < 32 && port == 0; attempt++)
+	{
+		uint16_t candidate = 20000 + (getpid() * 7 + attempt * 131) % 20000;
+		if(receiver.open(candidate))
+			port = candidate;
+	}
+
+	if(port == 0)
+		return 1;
+
+	pid_t child = fork();
+	if(child == 0)
+	{
+		//Sender process, yields after every batch so a receiver sharing the core keeps the socket buffer from filling
+		int sender = socket(AF_INET, SOCK_DGRAM, 0);
+		if(sender < 0)
+			_exit(1);
+
+		sockaddr_in address;
+		memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_port = htons(port);
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+		uint8_t frame[MAVLINK_HEADER_V2 + MAVLINK_MAX_PAYLOAD + 2 + MAVLINK_SIGNATURE_LENGTH];
+
+		for(int i = 0; i < BENCH_DATAGRAMS; i++)
+		{
+			int length = generateCommand(frame, i);
+			if(sendto(sender, frame, length, 0, (sockaddr *) &address, sizeof(address)) != length)
+				_exit(1);
+
+			if(i % MAVLINK_UDP_BATCH == MAVLINK_UDP_BATCH - 1)
+				sched_yield();
+		}
+
+		close(sender);
+		_exit(0);
+	}
+
+	//Time from the first datagram to the last, a drain that times out after the sender is done ends early
+	int received = receiver.receive(5000);
+	double startTime = wallSeconds(), endTime = startTime;
+	uint8_t senderDone = 0;
+
+	while(received < BENCH_DATAGRAMS)
+	{
+		int count = receiver.receive(100);
+		if(count > 0)
+		{
+			received += count;
+			endTime = wallSeconds();
+		}
+		else if(senderDone)
+			break;
+		else
+			senderDone = waitpid(child, NULL, WNOHANG) == child;
+	}
+
+	if(!senderDone)
+		waitpid(child, NULL, 0);
+
+	mavlink_ingest_stats_t stats = ingest.getStats();
+	double elapsed = endTime - startTime;
+
+	printf("MAVLink over loopback UDP: %u of %u datagrams received, %u committed, %.0f commands/s\n", (uint32_t) received,
+		(uint32_t) BENCH_DATAGRAMS, stats.commands, elapsed > 0 ? stats.commands / elapsed : 0.0);
+
+	return received == 0 || stats.checksumErrors != 0 || stats.truncatedDatagrams != 0;
+}
+
+static int benchParser()
+{
+	static uint8_t stream[1 << 16];
+	int length = 0, frames = 0;
+
+	while(length + MAVLINK_HEADER_V2 + MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_LEN + 2 + MAVLINK_SIGNATURE_LENGTH <= (int) sizeof(stream))
+		length += generateCommand(stream + length, frames++);
+
+	const int passes = 400;
+	MavlinkParser parser;
+	uint32_t messages = 0;
+
+	double startTime = wallSeconds();
+	for(int pass = 0; pass < passes; pass++)
+	{
+		for(int i = 0; i < length; i++)
+			messages += parser.parse(stream[i]);
+	}
+	double elapsed = wallSeconds() - startTime;
+
+	mavlink_parser_stats_t stats = parser.getStats();
+	if(messages != (uint32_t) frames * passes || stats.checksumErrors != 0)
+	{
+		printf("parser lost frames: %u of %u\n", messages, frames * passes);
+		return 1;
+	}
+
+	printf("MAVLink parse: %.1f MB/s, %.2f M frames/s, %.1f ns per byte\n", (double) length * passes / elapsed / 1e6,
+		messages / elapsed / 1e6, elapsed * 1e9 / ((double) length * passes));
+
+	return 0;
+}
+
+int main()
+{
+	if(benchUdp() != 0)
+		return 1;
+
+	return benchParser();
+}
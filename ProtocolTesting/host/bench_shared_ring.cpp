@@ -0,0 +1,129 @@
+//Publish to read latency of the shared memory frame ring with a separate reader process, and the cost of a read
+#include <algorithm>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#include "SharedFrameBridge.h"
+
+#define BENCH_FRAMES 50000
+
+//Median publish to read latency the ring is meant to reach
+#define BENCH_TARGET_NANOS 1000
+
+//Empty polls a reader spins through before yielding, so a reader on its own core never pays for a system call
+#define BENCH_SPIN_POLLS 512
+
+static uint64_t nowNanos()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1000000000ull + now.tv_nsec;
+}
+
+int main()
+{
+	char name[64];
+	snprintf(name, sizeof(name), "/fce_bench_%d", (int) getpid());
+
+	SharedFrameBridge bridge(name);
+	if(bridge.open() != SHARED_FRAME_SUCCESS)
+		return 1;
+
+	int results[2];
+	int ready[2];
+	if(pipe(results) != 0 || pipe(ready) != 0)
+		return 1;
+
+	pid_t child = fork();
+	if(child == 0)
+	{
+		//Reader process, spins on the ring and notes how long after publishing each frame was seen
+		shared_frame_reader_t reader;
+		if(shared_frame_reader_open(&reader, name) != 0)
+			_exit(1);
+
+		char byte = 1;
+		if(write(ready[1], &byte, 1) != 1)
+			_exit(1);
+
+		std::vector<uint32_t> latencies;
+		latencies.reserve(BENCH_FRAMES);
+
+		uint32_t emptyPolls = 0;
+
+		for(uint32_t sequence = 0; sequence < BENCH_FRAMES;)
+		{
+			shared_frame_t frame;
+			if(!shared_frame_reader_next(&reader, &frame))
+			{
+				//A reader sharing the core with the writer still has to give it the core
+				if(++emptyPolls >= BENCH_SPIN_POLLS)
+				{
+					emptyPolls = 0;
+					sched_yield();
+				}
+
+				continue;
+			}
+
+			emptyPolls = 0;
+
+			latencies.push_back((uint32_t) (nowNanos() - frame.timestamp));
+			sequence = frame.sequence;
+		}
+
+		std::sort(latencies.begin(), latencies.end());
+		uint32_t summary[4] = { latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100], latencies.back(), (uint32_t) reader.overruns };
+
+		//Cost of polling the newest frame, a plain memory read with no system call
+		shared_frame_t frame;
+		uint64_t startTime = nowNanos();
+		for(int i = 0; i < 10000000; i++)
+			shared_frame_reader_latest(&reader, &frame);
+		uint32_t pollNanos = (uint32_t) ((nowNanos() - startTime) / 10000);
+
+		if(write(results[1], summary, sizeof(summary)) != sizeof(summary) || write(results[1], &pollNanos, sizeof(pollNanos)) != sizeof(pollNanos))
+			_exit(1);
+
+		shared_frame_reader_close(&reader);
+		_exit(0);
+	}
+
+	char byte;
+	if(read(ready[0], &byte, 1) != 1)
+		return 1;
+
+	//Publish every 20 us, far faster than any real frame rate, yielding so a reader sharing the core can run
+	FlightFrame frame = FlightFrame();
+	for(uint32_t sequence = 1; sequence <= BENCH_FRAMES; sequence++)
+	{
+		uint64_t due = nowNanos() + 20000;
+		frame.sequence = sequence;
+		frame.timestamp = nowNanos();
+		bridge.onFrameCommit(frame);
+
+		while(nowNanos() < due)
+			sched_yield();
+	}
+
+	uint32_t summary[4];
+	uint32_t pollNanos;
+	if(read(results[0], summary, sizeof(summary)) != sizeof(summary) || read(results[0], &pollNanos, sizeof(pollNanos)) != sizeof(pollNanos))
+		return 1;
+
+	waitpid(child, NULL, 0);
+	bridge.remove();
+
+	printf("shared ring publish to read latency over %u frames: median %u ns, p99 %u ns, max %u ns, %u overruns\n",
+		(uint32_t) BENCH_FRAMES, summary[0], summary[1], summary[2], summary[3]);
+	printf("shared_frame_reader_latest: %.1f ns per call\n", pollNanos / 1000.0);
+
+	//Reported rather than failed on, a reader sharing one core with the writer waits on the scheduler instead of the ring
+	printf("median latency target %u ns: %s (%ld online cpus)\n", (uint32_t) BENCH_TARGET_NANOS,
+		summary[0] < BENCH_TARGET_NANOS ? "PASS" : "MISSED", sysconf(_SC_NPROCESSORS_ONLN));
+
+	return 0;
+}
@@ -0,0 +1,15 @@
+//Mock of the Arduino core functions the library uses, for host builds
+#ifndef MOCK_ARDUINO_H
+#define MOCK_ARDUINO_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <esp_attr.h>
+
+unsigned long micros();
+unsigned long millis();
+void delay(uint32_t milliseconds);
+void delayMicroseconds(uint32_t microseconds);
+
+#endif
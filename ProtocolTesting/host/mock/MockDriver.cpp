@@ -0,0 +1,479 @@
+#include <pthread.h>
+#include <time.h>
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <soc/mcpwm_periph.h>
+#include "MockDriver.h"
+
+mcpwm_dev_t MCPWM0;
+mcpwm_dev_t MCPWM1;
+
+static mock_timer_t timers[MCPWM_UNIT_MAX][MCPWM_TIMER_MAX];
+static int syncPins[MCPWM_UNIT_MAX][3];
+static mock_rmt_t rmtChannels[RMT_CHANNEL_MAX];
+static mock_driver_calls_t calls;
+static int32_t failAfter = -1;
+static uint8_t failOnce = 0;
+static FlightClock * mockClock = NULL;
+static pthread_mutex_t callLock = PTHREAD_MUTEX_INITIALIZER;
+
+//Latched capture values and edges
+static uint32_t captureValues[MCPWM_UNIT_MAX][3];
+static uint32_t captureEdges[MCPWM_UNIT_MAX][3];
+
+//Registered interrupt handlers
+static void (*isrHandlers[MCPWM_UNIT_MAX])(void *);
+static void * isrArgs[MCPWM_UNIT_MAX];
+
+//Count a call and decide whether it fails
+static esp_err_t countCall(uint32_t * counter)
+{
+	//Both MCPWM units may be driven from different threads during a parallel init
+	pthread_mutex_lock(&callLock);
+
+	calls.total++;
+	(*counter)++;
+
+	esp_err_t result = ESP_OK;
+	if(failAfter == 0)
+	{
+		result = ESP_FAIL;
+		if(failOnce)
+			failAfter = -1;
+	}
+	else if(failAfter > 0)
+		failAfter--;
+
+	pthread_mutex_unlock(&callLock);
+	return result;
+}
+
+static uint8_t validTimer(mcpwm_unit_t unit, mcpwm_timer_t timer)
+{
+	return unit >= 0 && unit < MCPWM_UNIT_MAX && timer >= 0 && timer < MCPWM_TIMER_MAX;
+}
+
+void mockDriverReset()
+{
+	for(int unit = 0; unit < MCPWM_UNIT_MAX; unit++)
+	{
+		for(int timer = 0; timer < MCPWM_TIMER_MAX; timer++)
+		{
+			timers[unit][timer] = mock_timer_t();
+			timers[unit][timer].pin = -1;
+			timers[unit][timer].syncSignal = -1;
+			timers[unit][timer].syncOutput = MCPWM_SWSYNC_SOURCE_DISABLED;
+		}
+
+		for(int i = 0; i < 3; i++)
+		{
+			syncPins[unit][i] = -1;
+			captureValues[unit][i] = 0;
+			captureEdges[unit][i] = 0;
+		}
+
+		isrHandlers[unit] = NULL;
+		isrArgs[unit] = NULL;
+	}
+
+	for(int i = 0; i < RMT_CHANNEL_MAX; i++)
+	{
+		rmtChannels[i] = mock_rmt_t();
+		rmtChannels[i].pin = -1;
+	}
+
+	MCPWM0 = mcpwm_dev_t();
+	MCPWM1 = mcpwm_dev_t();
+	calls = mock_driver_calls_t();
+	failAfter = -1;
+	failOnce = 0;
+}
+
+void mockDriverSetClock(FlightClock * clock)
+{
+	mockClock = clock;
+}
+
+void mockDriverFailAfter(int32_t count)
+{
+	failAfter = count;
+	failOnce = 0;
+}
+
+void mockDriverFailOnce(int32_t count)
+{
+	failAfter = count;
+	failOnce = 1;
+}
+
+mock_driver_calls_t mockDriverCalls()
+{
+	return calls;
+}
+
+const mock_timer_t & mockDriverTimer(int unit, int timer)
+{
+	return timers[unit][timer];
+}
+
+int mockDriverSyncPin(int unit, int syncInput)
+{
+	return syncPins[unit][syncInput];
+}
+
+const mock_rmt_t & mockDriverRmt(int channel)
+{
+	return rmtChannels[channel];
+}
+
+void mockDriverCaptureEdge(int unit, int signal, uint8_t rising, uint32_t ticks)
+{
+	captureValues[unit][signal] = ticks;
+	captureEdges[unit][signal] = rising ? 1 : 2;
+
+	mcpwm_dev_t * device = unit == 0 ? &MCPWM0 : &MCPWM1;
+	device->int_st.val |= 1u << (27 + signal);
+
+	if(isrHandlers[unit] != NULL && (device->int_ena.val & (1u << (27 + signal))))
+	{
+		mockRtosSetIsrContext(1);
+		isrHandlers[unit](isrArgs[unit]);
+		mockRtosSetIsrContext(0);
+	}
+
+	//Clearing a bit in int_clr clears it in int_st
+	device->int_st.val &= ~device->int_clr.val;
+	device->int_clr.val = 0;
+}
+
+esp_err_t mcpwm_gpio_init(mcpwm_unit_t mcpwm_num, mcpwm_io_signals_t io_signal, int gpio_num)
+{
+	esp_err_t result = countCall(&calls.gpioInit);
+	if(result != ESP_OK || mcpwm_num < 0 || mcpwm_num >= MCPWM_UNIT_MAX)
+		return result != ESP_OK ? result : ESP_ERR_INVALID_ARG;
+
+	if(io_signal <= MCPWM2B && io_signal % 2 == 0)
+		timers[mcpwm_num][io_signal / 2].pin = gpio_num;
+	else if(io_signal >= MCPWM_SYNC_0 && io_signal <= MCPWM_SYNC_2)
+		syncPins[mcpwm_num][io_signal - MCPWM_SYNC_0] = gpio_num;
+
+	return ESP_OK;
+}
+
+esp_err_t mcpwm_init(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, const mcpwm_config_t * mcpwm_conf)
+{
+	esp_err_t result = countCall(&calls.init);
+	if(result != ESP_OK || !validTimer(mcpwm_num, timer_num) || mcpwm_conf == NULL)
+		return result != ESP_OK ? result : ESP_ERR_INVALID_ARG;
+
+	//mcpwm_init starts the timer as well
+	mock_timer_t & timer = timers[mcpwm_num][timer_num];
+	timer.configured = 1;
+	timer.running = 1;
+	timer.frequency = mcpwm_conf->frequency;
+	timer.duty = mcpwm_conf->cmpr_a;
+
+	return ESP_OK;
+}
+
+esp_err_t mcpwm_set_frequency(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, uint32_t frequency)
+{
+	esp_err_t result = countCall(&calls.setFrequency);
+	if(result != ESP_OK || !validTimer(mcpwm_num, timer_num) || !timers[mcpwm_num][timer_num].configured)
+		return result != ESP_OK ? result : ESP_ERR_INVALID_STATE;
+
+	timers[mcpwm_num][timer_num].frequency = frequency;
+	return ESP_OK;
+}
+
+esp_err_t mcpwm_set_duty(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, mcpwm_generator_t gen, float duty)
+{
+	esp_err_t result = countCall(&calls.setDuty);
+	if(result != ESP_OK || !validTimer(mcpwm_num, timer_num) || gen != MCPWM_OPR_A)
+		return result != ESP_OK ? result : ESP_ERR_INVALID_ARG;
+
+	//The real driver rejects dutys outside 0-100
+	if(duty < 0 || duty > 100 || !timers[mcpwm_num][timer_num].configured)
+		return ESP_ERR_INVALID_ARG;
+
+	mock_timer_t & timer = timers[mcpwm_num][timer_num];
+	timer.duty = duty;
+	timer.dutyWrites++;
+	timer.dutyTime = (mockClock != NULL ? mockClock : FlightClock::system())->now();
+
+	return ESP_OK;
+}
+
+esp_err_t mcpwm_start(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num)
+{
+	esp_err_t result = countCall(&calls.start);
+	if(result != ESP_OK || !validTimer(mcpwm_num, timer_num) || !timers[mcpwm_num][timer_num].configured)
+		return result != ESP_OK ? result : ESP_ERR_INVALID_STATE;
+
+	timers[mcpwm_num][timer_num].running = 1;
+	timers[mcpwm_num][timer_num].startTime = (mockClock != NULL ? mockClock : FlightClock::system())->now();
+	return ESP_OK;
+}
+
+esp_err_t mcpwm_stop(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num)
+{
+	esp_err_t result = countCall(&calls.stop);
+	if(result != ESP_OK || !validTimer(mcpwm_num, timer_num))
+		return result != ESP_OK ? result : ESP_ERR_INVALID_ARG;
+
+	timers[mcpwm_num][timer_num].running = 0;
+	return ESP_OK;
+}
+
+esp_err_t mcpwm_sync_enable(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, mcpwm_sync_signal_t sync_sig, uint32_t phase_val)
+{
+	esp_err_t result = countCall(&calls.syncEnable);
+	if(result != ESP_OK || !validTimer(mcpwm_num, timer_num))
+		return result != ESP_OK ? result : ESP_ERR_INVALID_ARG;
+
+	//The phase is in tenths of a percent of the period, and like IDF 4.4 a full period is rejected
+	if(sync_sig < MCPWM_SELECT_SYNC0 || sync_sig > MCPWM_SELECT_SYNC2 || phase_val > 999)
+		return ESP_ERR_INVALID_ARG;
+
+	timers[mcpwm_num][timer_num].syncSignal = sync_sig;
+	timers[mcpwm_num][timer_num].syncPhase = phase_val;
+	return ESP_OK;
+}
+
+esp_err_t mcpwm_sync_configure(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, const mcpwm_sync_config_t * sync_conf)
+{
+	esp_err_t result = countCall(&calls.syncEnable);
+	if(result != ESP_OK || !validTimer(mcpwm_num, timer_num) || sync_conf == NULL)
+		return result != ESP_OK ? result : ESP_ERR_INVALID_ARG;
+
+	if(sync_conf->sync_sig <= MCPWM_SELECT_NO_INPUT || sync_conf->sync_sig > MCPWM_SELECT_GPIO_SYNC2 || sync_conf->timer_val > 999)
+		return ESP_ERR_INVALID_ARG;
+
+	timers[mcpwm_num][timer_num].syncSignal = sync_conf->sync_sig;
+	timers[mcpwm_num][timer_num].syncPhase = sync_conf->timer_val;
+	return ESP_OK;
+}
+
+esp_err_t mcpwm_set_timer_sync_output(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, mcpwm_timer_sync_trigger_t trigger)
+{
+	esp_err_t result = countCall(&calls.syncOutput);
+	if(result != ESP_OK || !validTimer(mcpwm_num, timer_num))
+		return result != ESP_OK ? result : ESP_ERR_INVALID_ARG;
+
+	timers[mcpwm_num][timer_num].syncOutput = trigger;
+	return ESP_OK;
+}
+
+esp_err_t mcpwm_sync_disable(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num)
+{
+	esp_err_t result = countCall(&calls.syncDisable);
+	if(result != ESP_OK || !validTimer(mcpwm_num, timer_num))
+		return result != ESP_OK ? result : ESP_ERR_INVALID_ARG;
+
+	timers[mcpwm_num][timer_num].syncSignal = -1;
+	return ESP_OK;
+}
+
+esp_err_t mcpwm_capture_enable(mcpwm_unit_t mcpwm_num, mcpwm_capture_signal_t cap_sig, mcpwm_capture_on_edge_t cap_edge, uint32_t num_of_pulse)
+{
+	(void) cap_sig;
+	(void) cap_edge;
+	(void) num_of_pulse;
+
+	esp_err_t result = countCall(&calls.capture);
+	if(result != ESP_OK || mcpwm_num < 0 || mcpwm_num >= MCPWM_UNIT_MAX)
+		return result != ESP_OK ? result : ESP_ERR_INVALID_ARG;
+
+	return ESP_OK;
+}
+
+esp_err_t mcpwm_capture_disable(mcpwm_unit_t mcpwm_num, mcpwm_capture_signal_t cap_sig)
+{
+	(void) mcpwm_num;
+	(void) cap_sig;
+
+	return countCall(&calls.capture);
+}
+
+uint32_t mcpwm_capture_signal_get_value(mcpwm_unit_t mcpwm_num, mcpwm_capture_signal_t cap_sig)
+{
+	return captureValues[mcpwm_num][cap_sig];
+}
+
+uint32_t mcpwm_capture_signal_get_edge(mcpwm_unit_t mcpwm_num, mcpwm_capture_signal_t cap_sig)
+{
+	return captureEdges[mcpwm_num][cap_sig];
+}
+
+esp_err_t mcpwm_isr_register(mcpwm_unit_t mcpwm_num, void (*fn)(void *), void * arg, int intr_alloc_flags, void ** handle)
+{
+	(void) intr_alloc_flags;
+	(void) handle;
+
+	esp_err_t result = countCall(&calls.capture);
+	if(result != ESP_OK || mcpwm_num < 0 || mcpwm_num >= MCPWM_UNIT_MAX)
+		return result != ESP_OK ? result : ESP_ERR_INVALID_ARG;
+
+	isrHandlers[mcpwm_num] = fn;
+	isrArgs[mcpwm_num] = arg;
+	return ESP_OK;
+}
+
+esp_err_t rmt_config(const rmt_config_t * rmt_param)
+{
+	esp_err_t result = countCall(&calls.rmt);
+	if(result != ESP_OK || rmt_param == NULL || rmt_param->channel >= RMT_CHANNEL_MAX)
+		return result != ESP_OK ? result : ESP_ERR_INVALID_ARG;
+
+	mock_rmt_t & channel = rmtChannels[rmt_param->channel];
+	channel.pin = rmt_param->gpio_num;
+	channel.loop = rmt_param->tx_config.loop_en;
+	return ESP_OK;
+}
+
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags)
+{
+	(void) rx_buf_size;
+	(void) intr_alloc_flags;
+
+	esp_err_t result = countCall(&calls.rmt);
+	if(result != ESP_OK || channel >= RMT_CHANNEL_MAX || rmtChannels[channel].installed)
+		return result != ESP_OK ? result : ESP_ERR_INVALID_STATE;
+
+	rmtChannels[channel].installed = 1;
+	return ESP_OK;
+}
+
+esp_err_t rmt_driver_uninstall(rmt_channel_t channel)
+{
+	esp_err_t result = countCall(&calls.rmt);
+	if(result != ESP_OK || channel >= RMT_CHANNEL_MAX || !rmtChannels[channel].installed)
+		return result != ESP_OK ? result : ESP_ERR_INVALID_STATE;
+
+	int pin = rmtChannels[channel].pin;
+	rmtChannels[channel] = mock_rmt_t();
+	rmtChannels[channel].pin = pin;
+	return ESP_OK;
+}
+
+//Copy items into channel memory, noting writes that land under a running loop
+static void storeItems(mock_rmt_t & channel, const rmt_item32_t * items, int count, int offset)
+{
+	if(channel.transmitting && channel.loop)
+		channel.liveWrites++;
+
+	for(int i = 0; i < count && offset + i < MOCK_RMT_ITEMS; i++)
+		channel.items[offset + i] = items[i].val;
+
+	if(offset + count > channel.itemCount)
+		channel.itemCount = offset + count > MOCK_RMT_ITEMS ? MOCK_RMT_ITEMS : offset + count;
+}
+
+esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t * rmt_item, int item_num, bool wait_tx_done)
+{
+	(void) wait_tx_done;
+
+	esp_err_t result = countCall(&calls.rmt);
+	if(result != ESP_OK || channel >= RMT_CHANNEL_MAX || !rmtChannels[channel].installed)
+		return result != ESP_OK ? result : ESP_ERR_INVALID_STATE;
+
+	//A write replaces the memory contents and starts transmitting from the first item
+	rmtChannels[channel].transmitting = 0;
+	rmtChannels[channel].itemCount = 0;
+	storeItems(rmtChannels[channel], rmt_item, item_num, 0);
+	rmtChannels[channel].transmitting = 1;
+	rmtChannels[channel].frameWrites++;
+	return ESP_OK;
+}
+
+esp_err_t rmt_fill_tx_items(rmt_channel_t channel, const rmt_item32_t * item, uint16_t item_num, uint16_t mem_offset)
+{
+	esp_err_t result = countCall(&calls.rmt);
+	if(result != ESP_OK || channel >= RMT_CHANNEL_MAX || !rmtChannels[channel].installed)
+		return result != ESP_OK ? result : ESP_ERR_INVALID_STATE;
+
+	storeItems(rmtChannels[channel], item, item_num, mem_offset);
+	return ESP_OK;
+}
+
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, uint32_t wait_time)
+{
+	(void) wait_time;
+
+	esp_err_t result = countCall(&calls.rmt);
+	if(result != ESP_OK || channel >= RMT_CHANNEL_MAX || !rmtChannels[channel].installed)
+		return result != ESP_OK ? result : ESP_ERR_INVALID_STATE;
+
+	//A looping transmission never finishes, otherwise the frame in flight runs to its end marker
+	if(rmtChannels[channel].transmitting && rmtChannels[channel].loop)
+		return ESP_ERR_TIMEOUT;
+
+	rmtChannels[channel].transmitting = 0;
+	return ESP_OK;
+}
+
+esp_err_t rmt_set_tx_loop_mode(rmt_channel_t channel, bool loop_en)
+{
+	esp_err_t result = countCall(&calls.rmt);
+	if(result != ESP_OK || channel >= RMT_CHANNEL_MAX)
+		return result != ESP_OK ? result : ESP_ERR_INVALID_ARG;
+
+	rmtChannels[channel].loop = loop_en;
+	return ESP_OK;
+}
+
+esp_err_t rmt_tx_start(rmt_channel_t channel, bool tx_idx_rst)
+{
+	(void) tx_idx_rst;
+
+	esp_err_t result = countCall(&calls.rmt);
+	if(result != ESP_OK || channel >= RMT_CHANNEL_MAX || !rmtChannels[channel].installed)
+		return result != ESP_OK ? result : ESP_ERR_INVALID_STATE;
+
+	rmtChannels[channel].transmitting = 1;
+	return ESP_OK;
+}
+
+esp_err_t rmt_tx_stop(rmt_channel_t channel)
+{
+	esp_err_t result = countCall(&calls.rmt);
+	if(result != ESP_OK || channel >= RMT_CHANNEL_MAX)
+		return result != ESP_OK ? result : ESP_ERR_INVALID_ARG;
+
+	if(rmtChannels[channel].transmitting)
+		rmtChannels[channel].abortedFrames++;
+
+	rmtChannels[channel].transmitting = 0;
+	return ESP_OK;
+}
+
+int64_t esp_timer_get_time()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (int64_t) now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+unsigned long micros()
+{
+	return (unsigned long) esp_timer_get_time();
+}
+
+unsigned long millis()
+{
+	return (unsigned long) (esp_timer_get_time() / 1000);
+}
+
+void delay(uint32_t milliseconds)
+{
+	delayMicroseconds(milliseconds * 1000);
+}
+
+void delayMicroseconds(uint32_t microseconds)
+{
+	timespec duration;
+	duration.tv_sec = microseconds / 1000000;
+	duration.tv_nsec = (microseconds % 1000000) * 1000L;
+	nanosleep(&duration, NULL);
+}
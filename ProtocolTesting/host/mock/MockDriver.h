@@ -0,0 +1,154 @@
+/*
+ * Inspection and fault injection for the mock ESP-IDF driver layer used by the host tests. Every mcpwm_* and
+ * rmt_* call lands in a model of the two MCPWM units and the RMT channels instead of hardware.
+ */
+#ifndef MOCK_DRIVER_H
+#define MOCK_DRIVER_H
+
+#include <stdint.h>
+#include <driver/mcpwm.h>
+#include <driver/rmt.h>
+#include <freertos/FreeRTOS.h>
+#include "FlightClock.h"
+
+//Most RMT items kept per channel
+#define MOCK_RMT_ITEMS 64
+
+/**
+ * @brief State of one MCPWM timer and its A generator
+ */
+typedef struct
+{
+	//GPIO routed to the A generator, -1 if none
+	int pin;
+
+	//mcpwm_init has been called, and the timer is counting
+	uint8_t configured;
+	uint8_t running;
+
+	uint32_t frequency;
+	float duty;
+
+	//The mcpwm_sync_signal_t followed, -1 if sync is disabled, and the phase loaded on sync in tenths of a percent
+	int syncSignal;
+	uint32_t syncPhase;
+
+	//The mcpwm_timer_sync_trigger_t driving the sync output of the timer
+	int syncOutput;
+
+	//Number of duty writes, and the mock clock time of the last one
+	uint32_t dutyWrites;
+	uint64_t dutyTime;
+
+	//Mock clock time of the last mcpwm_start
+	uint64_t startTime;
+} mock_timer_t;
+
+/**
+ * @brief State of one RMT channel
+ */
+typedef struct
+{
+	uint8_t installed;
+	uint8_t loop;
+	uint8_t transmitting;
+	int pin;
+
+	//The items in channel memory
+	uint16_t itemCount;
+	uint32_t items[MOCK_RMT_ITEMS];
+
+	//Writes to channel memory made while a looping transmission was playing it out
+	uint32_t liveWrites;
+
+	//Transmissions cut off by rmt_tx_stop, and transmissions started by rmt_write_items
+	uint32_t abortedFrames;
+	uint32_t frameWrites;
+} mock_rmt_t;
+
+/**
+ * @brief Driver call counts since the last mockDriverReset
+ */
+typedef struct
+{
+	uint32_t total;
+	uint32_t gpioInit;
+	uint32_t init;
+	uint32_t setFrequency;
+	uint32_t setDuty;
+	uint32_t start;
+	uint32_t stop;
+	uint32_t syncEnable;
+	uint32_t syncDisable;
+	uint32_t syncOutput;
+	uint32_t capture;
+	uint32_t rmt;
+} mock_driver_calls_t;
+
+/**
+ * @brief Return every timer, RMT channel and counter to power on state
+ */
+void mockDriverReset();
+
+/**
+ * @brief Set the clock used to timestamp output changes, the system clock if null
+ */
+void mockDriverSetClock(FlightClock * clock);
+
+/**
+ * @brief Make every driver call after the next count calls fail, -1 to never fail
+ */
+void mockDriverFailAfter(int32_t calls);
+
+/**
+ * @brief Make only the driver call after the next count calls fail
+ */
+void mockDriverFailOnce(int32_t calls);
+
+/**
+ * @brief Get the driver call counts
+ */
+mock_driver_calls_t mockDriverCalls();
+
+/**
+ * @brief Get the state of a timer
+ */
+const mock_timer_t & mockDriverTimer(int unit, int timer);
+
+/**
+ * @brief Get the GPIO routed to a sync input of a unit, -1 if none
+ */
+int mockDriverSyncPin(int unit, int syncInput);
+
+/**
+ * @brief Get the state of an RMT channel
+ */
+const mock_rmt_t & mockDriverRmt(int channel);
+
+/**
+ * @brief Latch a capture edge on a unit and run the registered MCPWM interrupt handler, as the capture
+ * hardware would
+ * 
+ * @param unit The MCPWM unit
+ * @param signal The capture signal, 0-2
+ * @param rising 1 for a rising edge
+ * @param ticks The capture timer value
+ */
+void mockDriverCaptureEdge(int unit, int signal, uint8_t rising, uint32_t ticks);
+
+/**
+ * @brief Get the number of FreeRTOS tasks created since the program started
+ */
+uint32_t mockRtosTasksCreated();
+
+/**
+ * @brief Make xPortInIsrContext report whether the calling thread is in an ISR
+ */
+void mockRtosSetIsrContext(uint8_t isr);
+
+/**
+ * @brief Set the core xPortGetCoreID reports for the calling thread, tasks report the core they were pinned to
+ */
+void mockRtosSetCoreId(BaseType_t coreId);
+
+#endif
@@ -0,0 +1,143 @@
+//POSIX thread backed FreeRTOS task and semaphore mock
+#include <pthread.h>
+#include <sched.h>
+#include <semaphore.h>
+#include <time.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include "MockDriver.h"
+
+struct MockSemaphore
+{
+	sem_t semaphore;
+};
+
+typedef struct
+{
+	TaskFunction_t task;
+	void * parameters;
+	BaseType_t coreId;
+} mock_task_t;
+
+static uint32_t tasksCreated = 0;
+static __thread BaseType_t inIsr = 0;
+static __thread BaseType_t currentCore = 0;
+
+static void * runTask(void * arg)
+{
+	mock_task_t start = *(mock_task_t *) arg;
+	delete (mock_task_t *) arg;
+
+	currentCore = start.coreId;
+	start.task(start.parameters);
+	return NULL;
+}
+
+BaseType_t xPortGetCoreID()
+{
+	return currentCore;
+}
+
+BaseType_t xPortInIsrContext()
+{
+	return inIsr;
+}
+
+void mockRtosSetIsrContext(uint8_t isr)
+{
+	inIsr = isr;
+}
+
+void mockRtosSetCoreId(BaseType_t coreId)
+{
+	currentCore = coreId;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char * name, uint32_t stackDepth, void * parameters,
+	UBaseType_t priority, TaskHandle_t * createdTask, BaseType_t coreId)
+{
+	(void) name;
+	(void) stackDepth;
+	(void) priority;
+
+	mock_task_t * start = new mock_task_t();
+	start->task = task;
+	start->parameters = parameters;
+
+	//Tasks without affinity report the core of their creator
+	start->coreId = coreId >= 0 && coreId < portNUM_PROCESSORS ? coreId : currentCore;
+
+	pthread_t thread;
+	if(pthread_create(&thread, NULL, runTask, start) != 0)
+	{
+		delete start;
+		return pdFAIL;
+	}
+
+	pthread_detach(thread);
+	__atomic_fetch_add(&tasksCreated, 1, __ATOMIC_RELAXED);
+
+	if(createdTask != NULL)
+		*createdTask = (TaskHandle_t) thread;
+
+	return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+	(void) task;
+	pthread_exit(NULL);
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task)
+{
+	(void) task;
+	return 1;
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+	timespec duration = { (time_t) (ticks / 1000), (long) (ticks % 1000) * 1000000 };
+	nanosleep(&duration, NULL);
+}
+
+void vPortYield()
+{
+	sched_yield();
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+	MockSemaphore * semaphore = new MockSemaphore();
+	sem_init(&semaphore->semaphore, 0, 0);
+	return semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+	if(ticks == 0)
+		return sem_trywait(&semaphore->semaphore) == 0 ? pdTRUE : pdFALSE;
+
+	while(sem_wait(&semaphore->semaphore) != 0)
+		;
+
+	return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+	sem_post(&semaphore->semaphore);
+	return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+	sem_destroy(&semaphore->semaphore);
+	delete semaphore;
+}
+
+uint32_t mockRtosTasksCreated()
+{
+	return __atomic_load_n(&tasksCreated, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,67 @@
+//Mock of the ESP-IDF 4.4 legacy MCPWM driver for host builds, see MockDriver.h for inspecting what was written
+#ifndef MOCK_DRIVER_MCPWM_H
+#define MOCK_DRIVER_MCPWM_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <esp_err.h>
+
+typedef enum { MCPWM_UNIT_0 = 0, MCPWM_UNIT_1, MCPWM_UNIT_MAX } mcpwm_unit_t;
+typedef enum { MCPWM_TIMER_0 = 0, MCPWM_TIMER_1, MCPWM_TIMER_2, MCPWM_TIMER_MAX } mcpwm_timer_t;
+typedef enum { MCPWM_OPR_A = 0, MCPWM_OPR_B, MCPWM_OPR_MAX } mcpwm_generator_t;
+typedef enum { MCPWM_DUTY_MODE_0 = 0, MCPWM_DUTY_MODE_1, MCPWM_DUTY_MODE_MAX } mcpwm_duty_type_t;
+typedef enum { MCPWM_FREEZE_COUNTER = 0, MCPWM_UP_COUNTER, MCPWM_DOWN_COUNTER, MCPWM_UP_DOWN_COUNTER } mcpwm_counter_type_t;
+typedef enum
+{
+	MCPWM_SELECT_NO_INPUT = 0, MCPWM_SELECT_TIMER0_SYNC, MCPWM_SELECT_TIMER1_SYNC, MCPWM_SELECT_TIMER2_SYNC,
+	MCPWM_SELECT_GPIO_SYNC0, MCPWM_SELECT_GPIO_SYNC1, MCPWM_SELECT_GPIO_SYNC2
+} mcpwm_sync_signal_t;
+#define MCPWM_SELECT_SYNC0 MCPWM_SELECT_GPIO_SYNC0
+#define MCPWM_SELECT_SYNC1 MCPWM_SELECT_GPIO_SYNC1
+#define MCPWM_SELECT_SYNC2 MCPWM_SELECT_GPIO_SYNC2
+typedef enum { MCPWM_SWSYNC_SOURCE_SYNCIN = 0, MCPWM_SWSYNC_SOURCE_TEZ, MCPWM_SWSYNC_SOURCE_TEP, MCPWM_SWSYNC_SOURCE_DISABLED } mcpwm_timer_sync_trigger_t;
+typedef enum { MCPWM_TIMER_DIRECTION_UP = 0, MCPWM_TIMER_DIRECTION_DOWN } mcpwm_timer_direction_t;
+typedef enum { MCPWM_SELECT_CAP0 = 0, MCPWM_SELECT_CAP1, MCPWM_SELECT_CAP2 } mcpwm_capture_signal_t;
+typedef enum { MCPWM_NEG_EDGE = 1, MCPWM_POS_EDGE, MCPWM_BOTH_EDGE } mcpwm_capture_on_edge_t;
+
+typedef enum
+{
+	MCPWM0A = 0, MCPWM0B, MCPWM1A, MCPWM1B, MCPWM2A, MCPWM2B,
+	MCPWM_SYNC_0, MCPWM_SYNC_1, MCPWM_SYNC_2,
+	MCPWM_FAULT_0, MCPWM_FAULT_1, MCPWM_FAULT_2,
+	MCPWM_CAP_0 = 84, MCPWM_CAP_1, MCPWM_CAP_2
+} mcpwm_io_signals_t;
+
+typedef struct
+{
+	uint32_t frequency;
+	float cmpr_a;
+	float cmpr_b;
+	mcpwm_duty_type_t duty_mode;
+	mcpwm_counter_type_t counter_mode;
+} mcpwm_config_t;
+
+typedef struct
+{
+	mcpwm_sync_signal_t sync_sig;
+	uint32_t timer_val;
+	mcpwm_timer_direction_t count_direction;
+} mcpwm_sync_config_t;
+
+esp_err_t mcpwm_gpio_init(mcpwm_unit_t mcpwm_num, mcpwm_io_signals_t io_signal, int gpio_num);
+esp_err_t mcpwm_init(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, const mcpwm_config_t * mcpwm_conf);
+esp_err_t mcpwm_set_frequency(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, uint32_t frequency);
+esp_err_t mcpwm_set_duty(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, mcpwm_generator_t gen, float duty);
+esp_err_t mcpwm_start(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num);
+esp_err_t mcpwm_stop(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num);
+esp_err_t mcpwm_sync_enable(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, mcpwm_sync_signal_t sync_sig, uint32_t phase_val);
+esp_err_t mcpwm_sync_disable(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num);
+esp_err_t mcpwm_sync_configure(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, const mcpwm_sync_config_t * sync_conf);
+esp_err_t mcpwm_set_timer_sync_output(mcpwm_unit_t mcpwm_num, mcpwm_timer_t timer_num, mcpwm_timer_sync_trigger_t trigger);
+esp_err_t mcpwm_capture_enable(mcpwm_unit_t mcpwm_num, mcpwm_capture_signal_t cap_sig, mcpwm_capture_on_edge_t cap_edge, uint32_t num_of_pulse);
+esp_err_t mcpwm_capture_disable(mcpwm_unit_t mcpwm_num, mcpwm_capture_signal_t cap_sig);
+uint32_t mcpwm_capture_signal_get_value(mcpwm_unit_t mcpwm_num, mcpwm_capture_signal_t cap_sig);
+uint32_t mcpwm_capture_signal_get_edge(mcpwm_unit_t mcpwm_num, mcpwm_capture_signal_t cap_sig);
+esp_err_t mcpwm_isr_register(mcpwm_unit_t mcpwm_num, void (*fn)(void *), void * arg, int intr_alloc_flags, void ** handle);
+
+#endif
@@ -0,0 +1,66 @@
+//Mock of the ESP-IDF 4 legacy RMT driver for host builds, see MockDriver.h for inspecting what was written
+#ifndef MOCK_DRIVER_RMT_H
+#define MOCK_DRIVER_RMT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <esp_err.h>
+
+typedef enum
+{
+	RMT_CHANNEL_0 = 0, RMT_CHANNEL_1, RMT_CHANNEL_2, RMT_CHANNEL_3,
+	RMT_CHANNEL_4, RMT_CHANNEL_5, RMT_CHANNEL_6, RMT_CHANNEL_7, RMT_CHANNEL_MAX
+} rmt_channel_t;
+
+typedef enum { RMT_MODE_TX = 0, RMT_MODE_RX, RMT_MODE_MAX } rmt_mode_t;
+typedef enum { RMT_IDLE_LEVEL_LOW = 0, RMT_IDLE_LEVEL_HIGH } rmt_idle_level_t;
+typedef enum { RMT_CARRIER_LEVEL_LOW = 0, RMT_CARRIER_LEVEL_HIGH } rmt_carrier_level_t;
+
+typedef struct
+{
+	uint32_t carrier_freq_hz;
+	rmt_carrier_level_t carrier_level;
+	rmt_idle_level_t idle_level;
+	uint8_t carrier_duty_percent;
+	bool carrier_en;
+	bool loop_en;
+	bool idle_output_en;
+} rmt_tx_config_t;
+
+typedef struct
+{
+	rmt_mode_t rmt_mode;
+	rmt_channel_t channel;
+	int gpio_num;
+	uint8_t clk_div;
+	uint8_t mem_block_num;
+	uint32_t flags;
+	rmt_tx_config_t tx_config;
+} rmt_config_t;
+
+typedef struct
+{
+	union
+	{
+		struct
+		{
+			uint32_t duration0 : 15;
+			uint32_t level0 : 1;
+			uint32_t duration1 : 15;
+			uint32_t level1 : 1;
+		};
+		uint32_t val;
+	};
+} rmt_item32_t;
+
+esp_err_t rmt_config(const rmt_config_t * rmt_param);
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags);
+esp_err_t rmt_driver_uninstall(rmt_channel_t channel);
+esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t * rmt_item, int item_num, bool wait_tx_done);
+esp_err_t rmt_fill_tx_items(rmt_channel_t channel, const rmt_item32_t * item, uint16_t item_num, uint16_t mem_offset);
+esp_err_t rmt_wait_tx_done(rmt_channel_t channel, uint32_t wait_time);
+esp_err_t rmt_set_tx_loop_mode(rmt_channel_t channel, bool loop_en);
+esp_err_t rmt_tx_start(rmt_channel_t channel, bool tx_idx_rst);
+esp_err_t rmt_tx_stop(rmt_channel_t channel);
+
+#endif
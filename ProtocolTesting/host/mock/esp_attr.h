@@ -0,0 +1,8 @@
+//Mock of the ESP-IDF section attributes for host builds, everything lives in ordinary memory
+#ifndef MOCK_ESP_ATTR_H
+#define MOCK_ESP_ATTR_H
+
+#define IRAM_ATTR
+#define RTC_NOINIT_ATTR
+
+#endif
@@ -0,0 +1,9 @@
+//Mock of the ESP-IDF high resolution timer for host builds, backed by the host monotonic clock
+#ifndef MOCK_ESP_TIMER_H
+#define MOCK_ESP_TIMER_H
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time();
+
+#endif
@@ -0,0 +1,24 @@
+//Mock of the FreeRTOS kernel types the library uses, tasks run as POSIX threads
+#ifndef MOCK_FREERTOS_H
+#define MOCK_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define portNUM_PROCESSORS 2
+#define portMAX_DELAY 0xFFFFFFFF
+#define pdPASS 1
+#define pdFAIL 0
+#define pdTRUE 1
+#define pdFALSE 0
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+
+BaseType_t xPortGetCoreID();
+
+//Nonzero while running a handler from mockDriverCaptureEdge, or after mockRtosSetIsrContext
+BaseType_t xPortInIsrContext();
+
+#endif
@@ -0,0 +1,18 @@
+//Mock of the FreeRTOS binary semaphore API
+#ifndef MOCK_FREERTOS_SEMPHR_H
+#define MOCK_FREERTOS_SEMPHR_H
+
+#include "FreeRTOS.h"
+
+typedef struct MockSemaphore * SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary();
+
+//Only portMAX_DELAY and 0 are supported as timeouts
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks);
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore);
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore);
+
+#endif
@@ -0,0 +1,24 @@
+//Mock of the FreeRTOS task API, each task is a detached POSIX thread
+#ifndef MOCK_FREERTOS_TASK_H
+#define MOCK_FREERTOS_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef void (*TaskFunction_t)(void *);
+typedef void * TaskHandle_t;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char * name, uint32_t stackDepth, void * parameters,
+	UBaseType_t priority, TaskHandle_t * createdTask, BaseType_t coreId);
+
+//Only deleting the calling task is supported
+void vTaskDelete(TaskHandle_t task);
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task);
+
+void vTaskDelay(TickType_t ticks);
+
+//Gives up the processor to another thread
+void vPortYield();
+#define taskYIELD() vPortYield()
+
+#endif
@@ -0,0 +1,17 @@
+//Mock of the MCPWM interrupt registers ReceiverCapture touches, for host builds
+#ifndef MOCK_SOC_MCPWM_PERIPH_H
+#define MOCK_SOC_MCPWM_PERIPH_H
+
+#include <stdint.h>
+
+typedef struct
+{
+	union { uint32_t val; } int_ena;
+	union { uint32_t val; } int_st;
+	union { uint32_t val; } int_clr;
+} mcpwm_dev_t;
+
+extern mcpwm_dev_t MCPWM0;
+extern mcpwm_dev_t MCPWM1;
+
+#endif
@@ -0,0 +1,184 @@
+//Lock free reads of the committed frame, from tasks racing the writer and from ISRs, and the published mix
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "HostTest.h"
+#include "MockDriver.h"
+#include "FlightControlEmulator.h"
+#include "ReceiverCapture.h"
+
+//Gives the tests control of the sequence lock
+class LockableEmulator : public FlightControlEmulator
+{
+public:
+	void holdLock() { __atomic_fetch_add(&this->stateLock, 1, __ATOMIC_RELEASE); }
+	void releaseLock() { __atomic_fetch_add(&this->stateLock, 1, __ATOMIC_RELEASE); }
+};
+
+typedef struct
+{
+	FlightControlEmulator * controller;
+	uint32_t commits;
+	uint8_t done;
+} writer_args_t;
+
+static void * writeFrames(void * arg)
+{
+	writer_args_t * args = (writer_args_t *) arg;
+
+	for(uint32_t i = 0; i < args->commits; i++)
+	{
+		args->controller->setThrottle(i % 2 ? 100 : 0);
+
+		if(i % 64 == 0)
+			sched_yield();
+	}
+
+	__atomic_store_n(&args->done, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+static void testTaskReadsNeverFail()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+
+	CHECK(controller.setThrottle(100) == FLIGHT_SUCCESS);
+	FlightFrame full;
+	CHECK(controller.getChannelState(full));
+
+	CHECK(controller.setThrottle(0) == FLIGHT_SUCCESS);
+	FlightFrame empty;
+	CHECK(controller.getChannelState(empty));
+
+	writer_args_t args = { &controller, 200000, 0 };
+	pthread_t writer;
+	CHECK(pthread_create(&writer, NULL, writeFrames, &args) == 0);
+
+	uint32_t reads = 0, failures = 0, torn = 0;
+
+	while(!__atomic_load_n(&args.done, __ATOMIC_ACQUIRE))
+	{
+		FlightFrame state;
+		reads++;
+
+		if(!controller.getChannelState(state))
+		{
+			failures++;
+			continue;
+		}
+
+		//Every copy is one whole commit, the value and duty of a channel always agree
+		float value = state.values[PWM_CHANNEL_THROTTLE - 1];
+		float duty = state.dutys[PWM_CHANNEL_THROTTLE - 1];
+		if(!((value == 100 && duty == full.dutys[PWM_CHANNEL_THROTTLE - 1]) || (value == 0 && duty == empty.dutys[PWM_CHANNEL_THROTTLE - 1])))
+			torn++;
+	}
+
+	pthread_join(writer, NULL);
+	printf("    %u reads racing %u commits\n", reads, args.commits);
+
+	CHECK(failures == 0);
+	CHECK(torn == 0);
+}
+
+typedef struct
+{
+	LockableEmulator * controller;
+	uint8_t result;
+	uint8_t done;
+} reader_args_t;
+
+static void * readFrame(void * arg)
+{
+	reader_args_t * args = (reader_args_t *) arg;
+
+	FlightFrame state;
+	args->result = args->controller->getChannelState(state);
+
+	__atomic_store_n(&args->done, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+static void testTaskWaitsForCommit()
+{
+	mockDriverReset();
+	LockableEmulator controller;
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+
+	//A task that finds a commit in progress waits for it rather than failing
+	controller.holdLock();
+
+	reader_args_t args = { &controller, 0, 0 };
+	pthread_t reader;
+	CHECK(pthread_create(&reader, NULL, readFrame, &args) == 0);
+
+	timespec wait = { 0, 20000000 };
+	nanosleep(&wait, NULL);
+	CHECK(!__atomic_load_n(&args.done, __ATOMIC_ACQUIRE));
+
+	controller.releaseLock();
+	pthread_join(reader, NULL);
+	CHECK(args.result == 1);
+}
+
+static void testIsrGivesUp()
+{
+	mockDriverReset();
+	LockableEmulator controller;
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+
+	//An ISR that interrupted the commit cannot wait for it
+	controller.holdLock();
+	mockRtosSetIsrContext(1);
+
+	FlightFrame state;
+	CHECK(controller.getChannelState(state) == 0);
+
+	mockRtosSetIsrContext(0);
+	controller.releaseLock();
+
+	mockRtosSetIsrContext(1);
+	CHECK(controller.getChannelState(state) == 1);
+	mockRtosSetIsrContext(0);
+}
+
+static void testPublishesMixedValues()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	ReceiverCapture receiver;
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(receiver.init() == PWM_SUCCESS);
+	CHECK(receiver.setChannelMode(PWM_CHANNEL_THROTTLE, RECEIVER_BLEND, .5) == PWM_SUCCESS);
+	controller.setReceiver(&receiver);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+
+	//A full stick pulse on the throttle capture input, channel 2 is unit 0 signal 1
+	mockDriverCaptureEdge(0, 1, 1, 1000);
+	mockDriverCaptureEdge(0, 1, 0, 1000 + RECEIVER_DEFAULT_HIGH * RECEIVER_TICKS_PER_US);
+
+	CHECK(controller.setThrottle(0) == FLIGHT_SUCCESS);
+
+	//Half of the full receiver value and half of the emulated 0
+	FlightFrame state;
+	CHECK(controller.getChannelState(state));
+	CHECK_NEAR(state.values[PWM_CHANNEL_THROTTLE - 1], 50, .001);
+	CHECK_NEAR(state.dutys[PWM_CHANNEL_THROTTLE - 1], (PWM_DUTY_THROTTLE_MINIMUM + PWM_DUTY_THROTTLE_MAXIMUM) / 2, .001);
+
+	controller.setReceiver(NULL);
+}
+
+int main()
+{
+	RUN_TEST(testTaskReadsNeverFail);
+	RUN_TEST(testTaskWaitsForCommit);
+	RUN_TEST(testIsrGivesUp);
+	RUN_TEST(testPublishesMixedValues);
+
+	return hostTestResult();
+}
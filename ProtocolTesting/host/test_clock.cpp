@@ -0,0 +1,49 @@
+//VirtualClock behaviour, built without the mock driver to show the clock has no ESP dependency
+#include "HostTest.h"
+#include "VirtualClock.h"
+
+static void testStartsAtGivenTime()
+{
+	VirtualClock zero;
+	VirtualClock later(1234);
+
+	CHECK(zero.now() == 0);
+	CHECK(later.now() == 1234);
+}
+
+static void testSleepJumpsForward()
+{
+	VirtualClock clock(100);
+
+	clock.sleepUntil(5000);
+	CHECK(clock.now() == 5000);
+
+	//Sleeping until a time already passed returns without moving the clock back
+	clock.sleepUntil(10);
+	CHECK(clock.now() == 5000);
+
+	clock.delayMicros(250);
+	CHECK(clock.now() == 5250);
+
+	clock.advance(750);
+	CHECK(clock.now() == 6000);
+}
+
+static void testThroughBaseClass()
+{
+	VirtualClock virtualClock;
+	FlightClock * clock = &virtualClock;
+
+	clock->delayMicros(18302);
+	clock->sleepUntil(clock->now() + 18302);
+	CHECK(clock->now() == 2 * 18302);
+}
+
+int main()
+{
+	RUN_TEST(testStartsAtGivenTime);
+	RUN_TEST(testSleepJumpsForward);
+	RUN_TEST(testThroughBaseClass);
+
+	return hostTestResult();
+}
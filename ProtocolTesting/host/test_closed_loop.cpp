@@ -0,0 +1,112 @@
+//Closed loop regression, an altitude hold controller flying the emulator with FlightDynamics closing the loop
+#include <math.h>
+#include "HostTest.h"
+#include "MockDriver.h"
+#include "FlightControlEmulator.h"
+#include "FlightDynamics.h"
+#include "VirtualClock.h"
+
+#define HOVER_TARGET_M 10.f
+
+//Fly one vehicle for a number of frames, climbing to the target and then pitching forward for the last third
+static void fly(FlightDynamics & dynamics, int vehicle, uint32_t frames)
+{
+	mockDriverReset();
+
+	VirtualClock clock;
+	mockDriverSetClock(&clock);
+
+	FlightControlEmulator controller;
+	FlightDynamicsInput input(&dynamics, vehicle);
+	controller.setClock(&clock);
+	controller.setFrameListener(&input);
+	controller.init();
+	controller.start();
+
+	const float dt = PWM_DEFAULT_PERIOD_US * 1e-6f;
+
+	for(uint32_t frame = 0; frame < frames; frame++)
+	{
+		//Proportional-derivative altitude hold around the hover throttle of half the maximum thrust
+		float error = HOVER_TARGET_M - dynamics.getAltitude(vehicle);
+		float throttle = 50 + error * 4 - dynamics.getClimbRate(vehicle) * 6;
+		controller.setThrottle(throttle < 0 ? 0 : (throttle > 100 ? 100 : throttle));
+
+		//Level the attitude, and tilt nose down once established in the hover
+		float pitchTarget = frame > frames * 2 / 3 ? .1f : 0;
+		controller.pitch((pitchTarget - dynamics.getPitch(vehicle)) * 2);
+		controller.roll(-dynamics.getRoll(vehicle) * 2);
+
+		controller.waitForNextFrame();
+		dynamics.step(dt);
+	}
+
+	mockDriverSetClock(NULL);
+}
+
+static void testClimbsAndHolds()
+{
+	FlightDynamics dynamics(1);
+	fly(dynamics, 0, 1200);
+
+	printf("    altitude %.3f m, climb %.3f m/s, x %.3f m\n", dynamics.getAltitude(0), dynamics.getClimbRate(0), dynamics.getX(0));
+	CHECK_NEAR(dynamics.getAltitude(0), HOVER_TARGET_M, 1.f);
+	CHECK(fabsf(dynamics.getClimbRate(0)) < 1.f);
+	CHECK(fabsf(dynamics.getRoll(0)) < .05f);
+
+	//Nose down moves the vehicle along its heading, which starts on +x
+	CHECK(dynamics.getX(0) > 1.f);
+	CHECK(fabsf(dynamics.getY(0)) < .1f);
+}
+
+static void testRepeatable()
+{
+	FlightDynamics first(1);
+	FlightDynamics second(1);
+	fly(first, 0, 600);
+	fly(second, 0, 600);
+
+	CHECK(first.getAltitude(0) == second.getAltitude(0));
+	CHECK(first.getX(0) == second.getX(0));
+	CHECK(first.getPitch(0) == second.getPitch(0));
+}
+
+static void testBatchedMatchesSingle()
+{
+	//A vehicle in a large padded batch steps exactly like one simulated alone
+	FlightDynamics single(1);
+	FlightDynamics batch(37);
+	fly(single, 0, 600);
+	fly(batch, 29, 600);
+
+	CHECK(batch.getAltitude(29) == single.getAltitude(0));
+	CHECK(batch.getX(29) == single.getX(0));
+	CHECK(batch.getHeadingX(29) == single.getHeadingX(0));
+
+	//Idle vehicles in the batch never left the ground
+	CHECK(batch.getAltitude(0) == 0);
+	CHECK(batch.getAltitude(36) == 0);
+}
+
+static void testGroundContact()
+{
+	FlightDynamics dynamics(1);
+	float idle[6] = { 50, 0, 50, 50, 0, 0 };
+	dynamics.setCommand(0, idle);
+
+	for(int i = 0; i < 100; i++)
+		dynamics.step(.01f);
+
+	CHECK(dynamics.getAltitude(0) == 0);
+	CHECK(dynamics.getClimbRate(0) == 0);
+}
+
+int main()
+{
+	RUN_TEST(testClimbsAndHolds);
+	RUN_TEST(testRepeatable);
+	RUN_TEST(testBatchedMatchesSingle);
+	RUN_TEST(testGroundContact);
+
+	return hostTestResult();
+}
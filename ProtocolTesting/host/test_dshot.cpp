@@ -0,0 +1,170 @@
+//DShot packet and symbol golden values, and tear free frame updates on the RMT
+#include "HostTest.h"
+#include "MockDriver.h"
+#include "DShotEncoder.h"
+#include "FlightControlEmulator.h"
+
+//RMT item word for a high then low pulse
+static uint32_t symbol(uint32_t high, uint32_t low)
+{
+	return high | (1u << 15) | (low << 16);
+}
+
+static void testPacketGolden()
+{
+	//Values worked by hand from the DShot specification, 11 value bits, telemetry, XOR nibble checksum
+	CHECK(DShotEncoder::packet(1046, 0) == 0x82C6);
+	CHECK(DShotEncoder::packet(1046, 1) == 0x82D7);
+	CHECK(DShotEncoder::packet(48, 0) == 0x0606);
+	CHECK(DShotEncoder::packet(2047, 0) == 0xFFEE);
+	CHECK(DShotEncoder::packet(0, 0) == 0x0000);
+
+	//Values above 11 bits are truncated rather than spilling into the telemetry bit
+	CHECK(DShotEncoder::packet(2048 + 1046, 0) == 0x82C6);
+}
+
+static void testThrottleGolden()
+{
+	CHECK(DShotEncoder::throttleValue(-5) == DSHOT_VALUE_DISARMED);
+	CHECK(DShotEncoder::throttleValue(0) == DSHOT_VALUE_DISARMED);
+	CHECK(DShotEncoder::throttleValue(.01f) == DSHOT_VALUE_MINIMUM);
+	CHECK(DShotEncoder::throttleValue(50) == 1048);
+	CHECK(DShotEncoder::throttleValue(100) == DSHOT_VALUE_MAXIMUM);
+	CHECK(DShotEncoder::throttleValue(150) == DSHOT_VALUE_MAXIMUM);
+}
+
+static void testSymbolGolden()
+{
+	//DShot600 is 133 ticks per bit at 80MHz, a 1 is high for 99 ticks and a 0 for 49
+	DShotEncoder dshot600(600);
+	uint32_t symbols[DSHOT_FRAME_SYMBOLS];
+	dshot600.encode(0x82C6, symbols);
+
+	const uint16_t bits = 0x82C6;
+	for(int i = 0; i < DSHOT_FRAME_BITS; i++)
+	{
+		uint8_t bit = (bits >> (15 - i)) & 1;
+		CHECK(symbols[i] == (bit ? symbol(99, 34) : symbol(49, 84)));
+	}
+
+	CHECK(symbols[DSHOT_FRAME_BITS] == (1064u | (1064u << 16)));
+	CHECK(symbols[DSHOT_FRAME_BITS + 1] == 0);
+
+	//DShot150 is 533 ticks per bit
+	DShotEncoder dshot150(150);
+	dshot150.encode(0xFFFF, symbols);
+	CHECK(symbols[0] == symbol(399, 134));
+	dshot150.encode(0x0000, symbols);
+	CHECK(symbols[0] == symbol(199, 334));
+}
+
+static void testUpdatesNeverTear()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.setThrottleMode(PWM_MODE_DSHOT600) == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+
+	int rmtChannel = PWM_CHANNEL_THROTTLE - 1;
+	DShotEncoder encoder(600);
+
+	for(int level = 0; level <= 100; level += 5)
+	{
+		CHECK(controller.setThrottle(level) == FLIGHT_SUCCESS);
+
+		//The channel loops exactly the frame for the new value
+		uint32_t expected[DSHOT_FRAME_SYMBOLS];
+		encoder.encode(DShotEncoder::packet(DShotEncoder::throttleValue(level), 0), expected);
+
+		const mock_rmt_t & rmt = mockDriverRmt(rmtChannel);
+		CHECK(rmt.transmitting && rmt.loop);
+		CHECK(rmt.itemCount == DSHOT_FRAME_SYMBOLS);
+		for(int i = 0; i < DSHOT_FRAME_SYMBOLS; i++)
+			CHECK(rmt.items[i] == expected[i]);
+	}
+
+	//No write landed under a playing loop and no frame was cut short
+	CHECK(mockDriverRmt(rmtChannel).liveWrites == 0);
+	CHECK(mockDriverRmt(rmtChannel).abortedFrames == 0);
+}
+
+static void testDutyReportsThrottle()
+{
+	mockDriverReset();
+	PWMHandler pwm;
+	CHECK(pwm.init() == PWM_SUCCESS);
+	CHECK(pwm.setChannelMode(PWM_CHANNEL_THROTTLE, PWM_MODE_DSHOT300) == PWM_SUCCESS);
+
+	CHECK(pwm.setChannelOutput(PWM_CHANNEL_THROTTLE, 0) == PWM_SUCCESS);
+	CHECK(pwm.getDuty(PWM_CHANNEL_THROTTLE) == 0);
+
+	CHECK(pwm.setChannelOutput(PWM_CHANNEL_THROTTLE, 100) == PWM_SUCCESS);
+	CHECK_NEAR(pwm.getDuty(PWM_CHANNEL_THROTTLE), 100, .0001);
+
+	//The reported value follows the quantized throttle actually sent
+	CHECK(pwm.setChannelOutput(PWM_CHANNEL_THROTTLE, 50) == PWM_SUCCESS);
+	CHECK_NEAR(pwm.getDuty(PWM_CHANNEL_THROTTLE), (1048 - 48) * 100. / 1999, .0001);
+
+	//Analog ESC modes report their real duty
+	CHECK(pwm.setChannelMode(PWM_CHANNEL_AUX_A, PWM_MODE_ONESHOT125) == PWM_SUCCESS);
+	CHECK(pwm.setChannelOutput(PWM_CHANNEL_AUX_A, 0) == PWM_SUCCESS);
+	CHECK_NEAR(pwm.getDuty(PWM_CHANNEL_AUX_A), 25, .0001);
+}
+
+static void testOnlyTransmitsWhileRunning()
+{
+	mockDriverReset();
+	int rmtChannel = PWM_CHANNEL_THROTTLE - 1;
+	DShotEncoder encoder(300);
+	uint32_t disarm[DSHOT_FRAME_SYMBOLS];
+	encoder.encode(DShotEncoder::packet(DSHOT_VALUE_DISARMED, 0), disarm);
+
+	{
+		PWMHandler pwm;
+		CHECK(pwm.init() == PWM_SUCCESS);
+
+		//Switching mode before start only loads the disarm frame
+		CHECK(pwm.setChannelMode(PWM_CHANNEL_THROTTLE, PWM_MODE_DSHOT300) == PWM_SUCCESS);
+		CHECK(mockDriverRmt(rmtChannel).installed);
+		CHECK(!mockDriverRmt(rmtChannel).transmitting);
+		CHECK(mockDriverRmt(rmtChannel).items[0] == disarm[0]);
+
+		//A value set while stopped waits in channel memory
+		CHECK(pwm.setChannelOutput(PWM_CHANNEL_THROTTLE, 50) == PWM_SUCCESS);
+		CHECK(!mockDriverRmt(rmtChannel).transmitting);
+
+		CHECK(pwm.start() == PWM_SUCCESS);
+		uint32_t expected[DSHOT_FRAME_SYMBOLS];
+		encoder.encode(DShotEncoder::packet(DShotEncoder::throttleValue(50), 0), expected);
+		CHECK(mockDriverRmt(rmtChannel).transmitting && mockDriverRmt(rmtChannel).loop);
+		for(int i = 0; i < DSHOT_FRAME_SYMBOLS; i++)
+			CHECK(mockDriverRmt(rmtChannel).items[i] == expected[i]);
+
+		//Stopping ends on a whole disarm frame and the loop does not carry on
+		CHECK(pwm.stop() == PWM_SUCCESS);
+		CHECK(!mockDriverRmt(rmtChannel).transmitting);
+		CHECK(!mockDriverRmt(rmtChannel).loop);
+		CHECK(mockDriverRmt(rmtChannel).abortedFrames == 0);
+		for(int i = 0; i < DSHOT_FRAME_SYMBOLS; i++)
+			CHECK(mockDriverRmt(rmtChannel).items[i] == disarm[i]);
+
+		CHECK(pwm.start() == PWM_SUCCESS);
+		CHECK(mockDriverRmt(rmtChannel).transmitting && mockDriverRmt(rmtChannel).loop);
+	}
+
+	//The handler gives the RMT channel back when it goes away
+	CHECK(!mockDriverRmt(rmtChannel).installed);
+}
+
+int main()
+{
+	RUN_TEST(testPacketGolden);
+	RUN_TEST(testThrottleGolden);
+	RUN_TEST(testSymbolGolden);
+	RUN_TEST(testUpdatesNeverTear);
+	RUN_TEST(testDutyReportsThrottle);
+	RUN_TEST(testOnlyTransmitsWhileRunning);
+
+	return hostTestResult();
+}
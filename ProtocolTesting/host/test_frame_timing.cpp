@@ -0,0 +1,129 @@
+//Frame pacing and driver timestamps under the virtual and system clocks, against the mock driver
+#include <time.h>
+#include "HostTest.h"
+#include "MockDriver.h"
+#include "FlightControlEmulator.h"
+#include "VirtualClock.h"
+
+static double wallSeconds()
+{
+	timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static void testFramePeriod()
+{
+	VirtualClock clock(1000);
+	FlightControlEmulator controller;
+	controller.setClock(&clock);
+
+	CHECK(controller.getFramePeriodMicros() == PWM_DEFAULT_PERIOD_US);
+
+	for(int i = 0; i < 10; i++)
+		controller.waitForNextFrame();
+
+	CHECK(controller.getFrameCount() == 10);
+	CHECK(clock.now() == 1000 + 10 * (uint64_t) PWM_DEFAULT_PERIOD_US);
+}
+
+static void testMissedFramesAreSkipped()
+{
+	VirtualClock clock;
+	FlightControlEmulator controller;
+	controller.setClock(&clock);
+
+	controller.waitForNextFrame();
+
+	//Fall three and a half frames behind, the next wait returns at once and pacing restarts from there
+	clock.advance(PWM_DEFAULT_PERIOD_US * 7 / 2);
+	uint64_t late = clock.now();
+	controller.waitForNextFrame();
+	CHECK(clock.now() == late);
+
+	controller.waitForNextFrame();
+	CHECK(clock.now() == late + PWM_DEFAULT_PERIOD_US);
+}
+
+//Run a fixed command sequence for a number of frames and fold every duty write time into a checksum
+static uint64_t runFlight(uint32_t frames)
+{
+	mockDriverReset();
+
+	VirtualClock clock;
+	mockDriverSetClock(&clock);
+
+	FlightControlEmulator controller;
+	controller.setClock(&clock);
+	controller.init();
+	controller.start();
+
+	uint64_t checksum = 0;
+
+	for(uint32_t frame = 0; frame < frames; frame++)
+	{
+		controller.setThrottle((frame * 7) % 101);
+		controller.pitch(((int) (frame % 21) - 10) * .1f);
+		controller.waitForNextFrame();
+
+		checksum = checksum * 31 + mockDriverTimer(0, 1).dutyTime;
+		checksum = checksum * 31 + (uint64_t) (mockDriverTimer(0, 1).duty * 1000);
+	}
+
+	mockDriverSetClock(NULL);
+	return checksum;
+}
+
+static void testHourOfFlightIsFastAndRepeatable()
+{
+	//One hour of frames at the default rate
+	uint32_t frames = 3600ull * 1000000 / PWM_DEFAULT_PERIOD_US;
+
+	double startTime = wallSeconds();
+	uint64_t first = runFlight(frames);
+	double elapsed = wallSeconds() - startTime;
+
+	uint64_t second = runFlight(frames);
+
+	printf("    %u frames (1 h emulated) in %.1f ms wall time\n", frames, elapsed * 1000);
+	CHECK(first == second);
+	CHECK(elapsed < 5);
+}
+
+static void testInitTimingUsesInjectedClock()
+{
+	mockDriverReset();
+
+	//A virtual clock does not move while init runs, so every phase reads zero
+	VirtualClock clock(5000);
+	PWMHandler pwm;
+	pwm.setClock(&clock);
+
+	CHECK(pwm.init() == PWM_SUCCESS);
+	CHECK(pwm.getInitTiming().totalMicros == 0);
+	CHECK(pwm.getInitTiming().gpioMicros == 0);
+	CHECK(pwm.getInitTiming().driverCalls > 0);
+}
+
+static void testSystemClockNeverWakesEarly()
+{
+	FlightClock * clock = FlightClock::system();
+
+	for(int i = 0; i < 20; i++)
+	{
+		uint64_t target = clock->now() + (i % 2 ? 300 : 2500);
+		clock->sleepUntil(target);
+		CHECK(clock->now() >= target);
+	}
+}
+
+int main()
+{
+	RUN_TEST(testFramePeriod);
+	RUN_TEST(testMissedFramesAreSkipped);
+	RUN_TEST(testHourOfFlightIsFastAndRepeatable);
+	RUN_TEST(testInitTimingUsesInjectedClock);
+	RUN_TEST(testSystemClockNeverWakesEarly);
+
+	return hostTestResult();
+}
@@ -0,0 +1,167 @@
+//Frame rate groups, rate validation, per group sync sources and the published state after rate changes
+#include "HostTest.h"
+#include "MockDriver.h"
+#include "FlightControlEmulator.h"
+#include "PWMHandler.h"
+
+//Channel n is on unit (n - 1) / 3, timer (n - 1) % 3
+static const mock_timer_t & channelTimer(int channel)
+{
+	return mockDriverTimer((channel - 1) / 3, (channel - 1) % 3);
+}
+
+static void checkPhasesInRange()
+{
+	for(int unit = 0; unit < 2; unit++)
+	{
+		for(int timer = 0; timer < 3; timer++)
+		{
+			CHECK(mockDriverTimer(unit, timer).syncPhase <= 999);
+			CHECK(mockDriverTimer(unit, timer).duty <= 100);
+		}
+	}
+}
+
+static void testThrottleRateTooHigh()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+	CHECK(controller.setThrottle(100) == FLIGHT_SUCCESS);
+
+	mock_timer_t before = channelTimer(PWM_CHANNEL_THROTTLE);
+
+	//The longest throttle pulse is about 1.98ms, more than a 600Hz frame
+	CHECK(controller.setThrottleFrequency(600) == FLIGHT_INVALID_INPUT);
+	CHECK(channelTimer(PWM_CHANNEL_THROTTLE).frequency == before.frequency);
+	CHECK(channelTimer(PWM_CHANNEL_THROTTLE).duty == before.duty);
+	CHECK(channelTimer(PWM_CHANNEL_THROTTLE).dutyWrites == before.dutyWrites);
+
+	//A 400Hz frame still fits it, and the same pulse width is kept
+	CHECK(controller.setThrottleFrequency(400) == FLIGHT_SUCCESS);
+	CHECK(channelTimer(PWM_CHANNEL_THROTTLE).frequency == 400);
+	CHECK_NEAR(channelTimer(PWM_CHANNEL_THROTTLE).duty, PWM_DUTY_THROTTLE_MAXIMUM * 400 / PWM_DEFAULT_APPROX_FREQUENCY_HZ, .01);
+
+	//The published state follows the rate change without another output call
+	FlightFrame state;
+	CHECK(controller.getChannelState(state));
+	CHECK_NEAR(state.dutys[PWM_CHANNEL_THROTTLE - 1], channelTimer(PWM_CHANNEL_THROTTLE).duty, .001);
+
+	checkPhasesInRange();
+}
+
+//Gives the tests the rate of a frame rate group
+class GroupEmulator : public FlightControlEmulator
+{
+public:
+	uint32_t groupFrequency(uint8_t group) { return this->pwm->getGroupFrequency(group); }
+};
+
+static void testThrottleRateRestoredOnFailure()
+{
+	mockDriverReset();
+	GroupEmulator controller;
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+	CHECK(controller.setThrottleFrequency(100) == FLIGHT_SUCCESS);
+
+	//A driver failure while moving the throttle into the group leaves group 1 at its old rate
+	mockDriverFailAfter(0);
+	CHECK(controller.setThrottleFrequency(200) == FLIGHT_PROTOCOL_FAILURE);
+	mockDriverFailAfter(-1);
+
+	CHECK(controller.groupFrequency(1) == 100);
+}
+
+static void testGroupChainTooLong()
+{
+	mockDriverReset();
+	PWMHandler pwm;
+	CHECK(pwm.init() == PWM_SUCCESS);
+
+	CHECK(pwm.setGroupFrequency(1, 400) == PWM_SUCCESS);
+	CHECK(pwm.setChannelGroup(1, 1) == PWM_SUCCESS);
+
+	//Two maximum servo pulses back to back are longer than a 400Hz frame
+	CHECK(pwm.setChannelGroup(2, 1) == PWM_RATE_TOO_HIGH);
+	CHECK(channelTimer(2).frequency == PWM_DEFAULT_APPROX_FREQUENCY_HZ);
+
+	//One channel alone does not fit at 600Hz either
+	CHECK(pwm.setGroupFrequency(1, 600) == PWM_RATE_TOO_HIGH);
+	CHECK(pwm.getGroupFrequency(1) == 400);
+	CHECK(channelTimer(1).frequency == 400);
+
+	//Switching an ESC channel back to servo is checked against its group chain too
+	CHECK(pwm.setChannelMode(3, PWM_MODE_ONESHOT125) == PWM_SUCCESS);
+	CHECK(pwm.setChannelGroup(3, 1) == PWM_SUCCESS);
+	CHECK(pwm.setChannelMode(3, PWM_MODE_SERVO) == PWM_RATE_TOO_HIGH);
+
+	for(int channel = 1; channel <= 6; channel++)
+		CHECK(pwm.setChannelOutput(channel, 100) == PWM_SUCCESS);
+
+	checkPhasesInRange();
+}
+
+static void testGroupSyncSources()
+{
+	mockDriverReset();
+	PWMHandler pwm;
+	CHECK(pwm.init() == PWM_SUCCESS);
+
+	CHECK(pwm.setGroupFrequency(1, 100) == PWM_SUCCESS);
+	CHECK(pwm.setChannelGroup(1, 1) == PWM_SUCCESS);
+	CHECK(pwm.setChannelGroup(3, 1) == PWM_SUCCESS);
+
+	//Groups other than 0 are clocked on one unit
+	CHECK(pwm.setChannelGroup(4, 1) == PWM_INVALID_CHANNEL);
+
+	for(int channel = 1; channel <= 6; channel++)
+		CHECK(pwm.setChannelOutput(channel, 100) == PWM_SUCCESS);
+
+	//The first channel of group 1 free runs and clocks the rest of the group
+	CHECK(channelTimer(1).syncSignal == -1);
+	CHECK(channelTimer(1).syncOutput == MCPWM_SWSYNC_SOURCE_TEZ);
+
+	CHECK(channelTimer(3).syncSignal == MCPWM_SELECT_TIMER0_SYNC);
+	CHECK(channelTimer(3).syncPhase == (uint32_t) (1000 - channelTimer(1).duty * 10));
+
+	//Group 0 still follows the sync pin shared by both units
+	CHECK(channelTimer(2).syncSignal == MCPWM_SELECT_SYNC0);
+	CHECK(channelTimer(2).syncPhase == 0);
+	for(int channel = 4; channel <= 6; channel++)
+		CHECK(channelTimer(channel).syncSignal == MCPWM_SELECT_SYNC0);
+
+	checkPhasesInRange();
+}
+
+static void testModeChangeCommits()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+	CHECK(controller.setThrottle(50) == FLIGHT_SUCCESS);
+
+	FlightFrame before;
+	CHECK(controller.getChannelState(before));
+
+	CHECK(controller.setThrottleMode(PWM_MODE_ONESHOT125) == FLIGHT_SUCCESS);
+
+	FlightFrame after;
+	CHECK(controller.getChannelState(after));
+	CHECK(after.sequence > before.sequence);
+	CHECK_NEAR(after.dutys[PWM_CHANNEL_THROTTLE - 1], channelTimer(PWM_CHANNEL_THROTTLE).duty, .001);
+	CHECK(after.dutys[PWM_CHANNEL_THROTTLE - 1] != before.dutys[PWM_CHANNEL_THROTTLE - 1]);
+}
+
+int main()
+{
+	RUN_TEST(testThrottleRateTooHigh);
+	RUN_TEST(testThrottleRateRestoredOnFailure);
+	RUN_TEST(testGroupChainTooLong);
+	RUN_TEST(testGroupSyncSources);
+	RUN_TEST(testModeChangeCommits);
+
+	return hostTestResult();
+}
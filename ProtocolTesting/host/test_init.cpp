@@ -0,0 +1,137 @@
+//MCPWM bring-up, serial and parallel, deferred channels, and driver failures
+#include "HostTest.h"
+#include "MockDriver.h"
+#include "FlightControlEmulator.h"
+#include "PWMHandler.h"
+
+//Channel n is on unit (n - 1) / 3, timer (n - 1) % 3
+static const mock_timer_t & channelTimer(int channel)
+{
+	return mockDriverTimer((channel - 1) / 3, (channel - 1) % 3);
+}
+
+static void testFullInit()
+{
+	mockDriverReset();
+	PWMHandler pwm;
+
+	CHECK(pwm.init() == PWM_SUCCESS);
+
+	//One sync route per unit, and a pin route and timer setup per channel, no separate frequency calls
+	mock_driver_calls_t calls = mockDriverCalls();
+	CHECK(calls.total == 14);
+	CHECK(calls.setFrequency == 0);
+	CHECK(pwm.getInitTiming().driverCalls == 14);
+
+	for(int channel = 1; channel <= 6; channel++)
+	{
+		CHECK(pwm.isChannelReady(channel));
+		CHECK(channelTimer(channel).configured);
+		CHECK(channelTimer(channel).frequency == PWM_DEFAULT_APPROX_FREQUENCY_HZ);
+	}
+}
+
+static void testSyncRouteFailure()
+{
+	mockDriverReset();
+	PWMHandler pwm;
+
+	//The very first call routes the sync input
+	mockDriverFailAfter(0);
+	CHECK(pwm.init() == PWM_FAILURE);
+	CHECK(!pwm.isInitialized());
+	CHECK(!pwm.isChannelReady(1));
+	mockDriverFailAfter(-1);
+}
+
+static void testParallelInitMatchesSerial()
+{
+	mockDriverReset();
+	PWMHandler serial;
+	CHECK(serial.init() == PWM_SUCCESS);
+
+	mock_timer_t serialTimers[6];
+	for(int channel = 1; channel <= 6; channel++)
+		serialTimers[channel - 1] = channelTimer(channel);
+
+	mockDriverReset();
+	uint32_t tasksBefore = mockRtosTasksCreated();
+
+	PWMHandler parallel;
+	parallel.setParallelInit(1);
+	CHECK(parallel.init() == PWM_SUCCESS);
+	CHECK(mockRtosTasksCreated() == tasksBefore + 1);
+	CHECK(mockDriverCalls().total == 14);
+	CHECK(parallel.getInitTiming().driverCalls == 14);
+
+	for(int channel = 1; channel <= 6; channel++)
+	{
+		CHECK(parallel.isChannelReady(channel));
+		CHECK(channelTimer(channel).configured == serialTimers[channel - 1].configured);
+		CHECK(channelTimer(channel).pin == serialTimers[channel - 1].pin);
+		CHECK(channelTimer(channel).frequency == serialTimers[channel - 1].frequency);
+	}
+
+	CHECK(mockDriverSyncPin(0, 0) == mockDriverSyncPin(1, 0));
+}
+
+static void testParallelInitSkipsSingleUnit()
+{
+	//Only unit 0 channels requested, no task is worth creating
+	mockDriverReset();
+	uint32_t tasksBefore = mockRtosTasksCreated();
+
+	PWMHandler pwm;
+	pwm.setParallelInit(1);
+	CHECK(pwm.init(0x07) == PWM_SUCCESS);
+	CHECK(mockRtosTasksCreated() == tasksBefore);
+}
+
+static void testParallelInitFailure()
+{
+	mockDriverReset();
+	PWMHandler pwm;
+	pwm.setParallelInit(1);
+
+	mockDriverFailAfter(0);
+	CHECK(pwm.init() == PWM_FAILURE);
+	CHECK(!pwm.isInitialized());
+	mockDriverFailAfter(-1);
+}
+
+static void testStartLeavesDeferredChannels()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+
+	//Only aileron and throttle are brought up, the idle on start must not touch the rest
+	CHECK(controller.init(0x03) == FLIGHT_SUCCESS);
+	uint32_t initCalls = mockDriverCalls().total;
+	CHECK(initCalls == 1 + 2 * 2);
+
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+	CHECK(channelTimer(1).running);
+	CHECK(channelTimer(2).running);
+
+	for(int channel = 3; channel <= 6; channel++)
+		CHECK(!channelTimer(channel).configured);
+
+	//Driving a deferred channel brings it up on the spot and starts it with the others
+	CHECK(controller.activateAUX1() == FLIGHT_SUCCESS);
+	CHECK(channelTimer(PWM_CHANNEL_AUX_A).configured);
+	CHECK(channelTimer(PWM_CHANNEL_AUX_A).running);
+	CHECK(channelTimer(PWM_CHANNEL_AUX_A).duty > 0);
+	CHECK(!channelTimer(PWM_CHANNEL_AUX_B).configured);
+}
+
+int main()
+{
+	RUN_TEST(testFullInit);
+	RUN_TEST(testSyncRouteFailure);
+	RUN_TEST(testParallelInitMatchesSerial);
+	RUN_TEST(testParallelInitSkipsSingleUnit);
+	RUN_TEST(testParallelInitFailure);
+	RUN_TEST(testStartLeavesDeferredChannels);
+
+	return hostTestResult();
+}
@@ -0,0 +1,276 @@
+//Manoeuvre assembly and stepping, and the batched channel frames it commits
+#include "HostTest.h"
+#include "MockDriver.h"
+#include "FlightControlEmulator.h"
+#include "ManeuverAssembler.h"
+#include "ManeuverProgram.h"
+
+static uint8_t loadProgram(ManeuverRunner & runner, const char * source)
+{
+	uint8_t code[MANEUVER_PROGRAM_SIZE];
+	int length = maneuverAssemble(source, code, MANEUVER_PROGRAM_SIZE, NULL);
+
+	return length >= 0 && runner.load(code, length) == MANEUVER_IDLE;
+}
+
+static float channelValue(FlightControlEmulator & controller, int channel)
+{
+	FlightFrame state;
+	controller.getChannelState(state);
+
+	return state.values[channel - 1];
+}
+
+static void testAssembler()
+{
+	uint8_t code[MANEUVER_PROGRAM_SIZE];
+	int length = maneuverAssemble("ramp throttle 80 50 # climb\nwait 2; abort_if in3 above 1.5\nend", code, MANEUVER_PROGRAM_SIZE, NULL);
+
+	const uint8_t expected[] = { MANEUVER_OP_RAMP, PWM_CHANNEL_THROTTLE, 0x40, 0x1F, 50, 0, MANEUVER_OP_WAIT, 2, 0,
+		MANEUVER_OP_ABORT_IF, MANEUVER_SOURCE_INPUT + 3, MANEUVER_COMPARE_ABOVE, 150, 0, MANEUVER_OP_END };
+
+	CHECK(length == sizeof(expected));
+	for(int i = 0; i < length && i < (int) sizeof(expected); i++)
+		CHECK(code[i] == expected[i]);
+
+	uint16_t errorStatement = 0;
+	CHECK(maneuverAssemble("set throttle 50; set throttle 101", code, MANEUVER_PROGRAM_SIZE, &errorStatement) == -1);
+	CHECK(errorStatement == 2);
+
+	//Frame and loop counts are never rounded
+	CHECK(maneuverAssemble("wait 2.5", code, MANEUVER_PROGRAM_SIZE, NULL) == -1);
+	CHECK(maneuverAssemble("ramp throttle 50 10.5", code, MANEUVER_PROGRAM_SIZE, NULL) == -1);
+	CHECK(maneuverAssemble("loop 1.5; next", code, MANEUVER_PROGRAM_SIZE, NULL) == -1);
+	CHECK(maneuverAssemble("wait 2.0; set throttle 12.5", code, MANEUVER_PROGRAM_SIZE, NULL) > 0);
+}
+
+static void testGuardInLoop()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	ManeuverRunner runner(&controller);
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+
+	//The guard is installed once, not once per pass
+	CHECK(loadProgram(runner, "loop 10; abort_if in0 above 1; set aux1 10; wait 1; next"));
+	CHECK(runner.start() == MANEUVER_RUNNING);
+
+	maneuver_state state;
+	int frames = 0;
+	do
+	{
+		state = runner.step();
+		frames++;
+	}
+	while(state == MANEUVER_RUNNING && frames < 100);
+
+	CHECK(state == MANEUVER_DONE);
+
+	//It still aborts the program
+	CHECK(runner.start() == MANEUVER_RUNNING);
+	CHECK(runner.step() == MANEUVER_RUNNING);
+	runner.setInput(0, 2);
+	CHECK(runner.step() == MANEUVER_ABORTED);
+
+	//More guards than the runner holds are rejected at load
+	CHECK(!loadProgram(runner, "abort_if in0 above 1; abort_if in1 above 1; abort_if in2 above 1; abort_if in3 above 1; abort_if in4 above 1"));
+}
+
+static void testErrorIdles()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	ManeuverRunner runner(&controller);
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+
+	//Starting idles the channels
+	float idleThrottle = channelValue(controller, PWM_CHANNEL_THROTTLE);
+
+	CHECK(loadProgram(runner, "set throttle 60; wait 1; set throttle 70; wait 1"));
+	CHECK(runner.start() == MANEUVER_RUNNING);
+	CHECK(runner.step() == MANEUVER_RUNNING);
+	CHECK(channelValue(controller, PWM_CHANNEL_THROTTLE) == 60);
+
+	//The frame commit fails, the runner stops and hands the channels back to idle
+	mockDriverFailOnce(0);
+	CHECK(runner.step() == MANEUVER_ERROR);
+	CHECK(channelValue(controller, PWM_CHANNEL_THROTTLE) == idleThrottle);
+}
+
+static void testRampOutlivesEnd()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	ManeuverRunner runner(&controller);
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+
+	CHECK(loadProgram(runner, "set throttle 0; ramp throttle 80 10; end"));
+	CHECK(runner.start() == MANEUVER_RUNNING);
+
+	//The frame that starts the ramp commits its starting point
+	FlightFrame before;
+	controller.getChannelState(before);
+	CHECK(runner.step() == MANEUVER_RUNNING);
+
+	FlightFrame after;
+	controller.getChannelState(after);
+	CHECK(after.sequence == before.sequence + 1);
+	CHECK(after.values[PWM_CHANNEL_THROTTLE - 1] == 0);
+
+	//END does not cut the ramp short, the program is done on the frame the ramp lands on its target
+	for(int frame = 1; frame < 10; frame++)
+	{
+		CHECK(runner.step() == MANEUVER_RUNNING);
+		CHECK_NEAR(channelValue(controller, PWM_CHANNEL_THROTTLE), 8 * frame, .001);
+	}
+
+	CHECK(runner.step() == MANEUVER_DONE);
+	CHECK(channelValue(controller, PWM_CHANNEL_THROTTLE) == 80);
+}
+
+static void testTrailingWait()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	ManeuverRunner runner(&controller);
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+
+	CHECK(loadProgram(runner, "set aux1 100; wait 3"));
+	CHECK(runner.start() == MANEUVER_RUNNING);
+
+	CHECK(runner.step() == MANEUVER_RUNNING);
+	CHECK(runner.step() == MANEUVER_RUNNING);
+	CHECK(runner.step() == MANEUVER_RUNNING);
+	CHECK(runner.step() == MANEUVER_DONE);
+}
+
+static void testLoopWithoutWaitYields()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	ManeuverRunner runner(&controller);
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+
+	//300 instructions with no WAIT run over several frames instead of failing
+	CHECK(loadProgram(runner, "loop 100; set aux1 10; set aux2 20; next; set aux1 30; end"));
+	CHECK(runner.start() == MANEUVER_RUNNING);
+
+	int frames = 0;
+	maneuver_state state;
+
+	do
+	{
+		state = runner.step();
+		frames++;
+	}
+	while(state == MANEUVER_RUNNING && frames < 100);
+
+	CHECK(state == MANEUVER_DONE);
+	CHECK(frames == (300 + 2 + MANEUVER_STEP_INSTRUCTIONS - 1) / MANEUVER_STEP_INSTRUCTIONS);
+	CHECK(channelValue(controller, PWM_CHANNEL_AUX_A) == 30);
+	CHECK(channelValue(controller, PWM_CHANNEL_AUX_B) == 20);
+}
+
+static void testOneChainPassPerFrame()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	ManeuverRunner runner(&controller);
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+
+	CHECK(loadProgram(runner, "set aileron 10; set elevator 20; set rudder 30; wait 1"));
+	CHECK(runner.start() == MANEUVER_RUNNING);
+
+	FlightFrame before;
+	controller.getChannelState(before);
+	mock_driver_calls_t callsBefore = mockDriverCalls();
+
+	CHECK(runner.step() == MANEUVER_RUNNING);
+
+	//One commit, and the group chain is written once from the aileron rather than once per channel
+	FlightFrame after;
+	controller.getChannelState(after);
+	mock_driver_calls_t callsAfter = mockDriverCalls();
+
+	CHECK(after.sequence == before.sequence + 1);
+	CHECK(callsAfter.setDuty - callsBefore.setDuty == 6);
+	CHECK(callsAfter.syncEnable - callsBefore.syncEnable == 6);
+	CHECK(after.values[PWM_CHANNEL_AILERON - 1] == 10);
+	CHECK(after.values[PWM_CHANNEL_ELEVATOR - 1] == 20);
+	CHECK(after.values[PWM_CHANNEL_RUDDER - 1] == 30);
+}
+
+static void testStartIsBatched()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+
+	//Idling all six channels writes each chain once, then starts each timer
+	mock_driver_calls_t before = mockDriverCalls();
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+	mock_driver_calls_t after = mockDriverCalls();
+
+	CHECK(after.total - before.total == 18);
+	CHECK(after.setDuty - before.setDuty == 6);
+	CHECK(after.start - before.start == 6);
+}
+
+static void testFrameIsAllOrNothing()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+
+	FlightFrame before;
+	controller.getChannelState(before);
+
+	float values[6] = { 10, 20, 30, 40, 50, 60 };
+	mock_driver_calls_t callsBefore = mockDriverCalls();
+
+	//An invalid channel stops the frame before anything is written
+	values[5] = 101;
+	CHECK(controller.setChannelFrame(values, 0x3F) == FLIGHT_INVALID_INPUT);
+	CHECK(mockDriverCalls().total == callsBefore.total);
+
+	//A driver failure part way leaves the emulated values and published state as they were
+	values[5] = 60;
+	mockDriverFailAfter(2);
+	CHECK(controller.setChannelFrame(values, 0x3F) == FLIGHT_PROTOCOL_FAILURE);
+	mockDriverFailAfter(-1);
+
+	FlightFrame after;
+	controller.getChannelState(after);
+	CHECK(after.sequence == before.sequence);
+
+	for(int i = 0; i < 6; i++)
+		CHECK(after.values[i] == before.values[i]);
+
+	CHECK(controller.setChannelFrame(values, 0x3F) == FLIGHT_SUCCESS);
+	controller.getChannelState(after);
+	CHECK(after.sequence == before.sequence + 1);
+	for(int i = 0; i < 6; i++)
+		CHECK(after.values[i] == values[i]);
+}
+
+int main()
+{
+	RUN_TEST(testAssembler);
+	RUN_TEST(testGuardInLoop);
+	RUN_TEST(testErrorIdles);
+	RUN_TEST(testRampOutlivesEnd);
+	RUN_TEST(testTrailingWait);
+	RUN_TEST(testLoopWithoutWaitYields);
+	RUN_TEST(testOneChainPassPerFrame);
+	RUN_TEST(testStartIsBatched);
+	RUN_TEST(testFrameIsAllOrNothing);
+
+	return hostTestResult();
+}
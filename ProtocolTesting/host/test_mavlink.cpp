@@ -0,0 +1,143 @@
+//MAVLink framing and checking against generated frames, with garbage, bad checksums and cut short datagrams
+#include "HostTest.h"
+#include "MavlinkGenerator.h"
+#include "MavlinkParser.h"
+
+static uint8_t stream[4096];
+
+//An RC_CHANNELS_OVERRIDE payload with chan1_raw set to the given value and targeting system 1
+static void overridePayload(uint8_t * payload, uint16_t chan1)
+{
+	memset(payload, 0, MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_LEN);
+	payload[0] = chan1 & 0xFF;
+	payload[1] = chan1 >> 8;
+	payload[16] = 1;
+}
+
+//Feed bytes, returning the number of messages completed
+static int feed(MavlinkParser & parser, const uint8_t * bytes, int length)
+{
+	int messages = 0;
+
+	for(int i = 0; i < length; i++)
+		messages += parser.parse(bytes[i]);
+
+	return messages;
+}
+
+static void testBothVersions()
+{
+	MavlinkParser parser;
+	uint8_t payload[MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_LEN];
+	overridePayload(payload, 1500);
+
+	int length = mavlinkGenerateFrame(stream, 0, 0, 0, MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE,
+		MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_CRC, payload, sizeof(payload));
+	CHECK(feed(parser, stream, length) == 1);
+	CHECK(parser.getMessage().id == MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE);
+	CHECK(parser.getMessage().systemId == 255);
+	CHECK(parser.getMessage().componentId == 190);
+	CHECK(memcmp(parser.getMessage().payload, payload, sizeof(payload)) == 0);
+
+	length = mavlinkGenerateFrame(stream, 1, 0, 1, MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE,
+		MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_CRC, payload, sizeof(payload));
+	CHECK(feed(parser, stream, length) == 1);
+
+	//Signed v2 frames carry a signature after the checksum
+	length = mavlinkGenerateFrame(stream, 1, MAVLINK_IFLAG_SIGNED, 2, MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE,
+		MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_CRC, payload, sizeof(payload));
+	CHECK(feed(parser, stream, length) == 1);
+	CHECK(!parser.receiving());
+
+	mavlink_parser_stats_t stats = parser.getStats();
+	CHECK(stats.frames == 3);
+	CHECK(stats.checksumErrors == 0 && stats.droppedBytes == 0);
+}
+
+static void testTrimmedPayload()
+{
+	MavlinkParser parser;
+
+	//A v2 sender drops the trailing zero bytes, the parser hands the full length back zero filled
+	uint8_t payload[MAVLINK_MSG_ID_MANUAL_CONTROL_LEN] = { 0x10, 0x20, 0, 0, 0, 0, 0, 0, 0, 0, 0 };
+	int length = mavlinkGenerateFrame(stream, 1, 0, 0, MAVLINK_MSG_ID_MANUAL_CONTROL, MAVLINK_MSG_ID_MANUAL_CONTROL_CRC,
+		payload, 2);
+
+	memset(stream + length, 0xEE, 8);
+	CHECK(feed(parser, stream, length) == 1);
+	CHECK(parser.getMessage().payload[0] == 0x10 && parser.getMessage().payload[1] == 0x20);
+
+	for(int i = 2; i < MAVLINK_MSG_ID_MANUAL_CONTROL_LEN; i++)
+		CHECK(parser.getMessage().payload[i] == 0);
+}
+
+static void testGarbageAndBadFrames()
+{
+	MavlinkParser parser;
+	uint8_t payload[MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_LEN];
+	overridePayload(payload, 1200);
+
+	int length = 0;
+	const uint8_t garbage[] = { 0x00, 0x11, 0x22, 0x33, 0x44 };
+	memcpy(stream, garbage, sizeof(garbage));
+	length += sizeof(garbage);
+
+	//A bad checksum
+	int bad = mavlinkGenerateFrame(stream + length, 1, 0, 0, MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE,
+		MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_CRC, payload, sizeof(payload));
+	stream[length + bad - 1] ^= 0x55;
+	length += bad;
+
+	//A message missing from the CRC_EXTRA table
+	length += mavlinkGenerateFrame(stream + length, 1, 0, 1, 33, 104, payload, 28);
+
+	//An incompatibility flag the parser does not know
+	length += mavlinkGenerateFrame(stream + length, 1, 0x02, 2, MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE,
+		MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_CRC, payload, sizeof(payload));
+
+	length += mavlinkGenerateFrame(stream + length, 0, 0, 3, MAVLINK_MSG_ID_HEARTBEAT, MAVLINK_MSG_ID_HEARTBEAT_CRC,
+		payload, MAVLINK_MSG_ID_HEARTBEAT_LEN);
+
+	CHECK(feed(parser, stream, length) == 1);
+	CHECK(parser.getMessage().id == MAVLINK_MSG_ID_HEARTBEAT);
+
+	mavlink_parser_stats_t stats = parser.getStats();
+	CHECK(stats.frames == 1);
+	CHECK(stats.checksumErrors == 1);
+	CHECK(stats.unknownMessages == 1);
+	CHECK(stats.incompatibleFrames == 1);
+	CHECK(stats.droppedBytes == sizeof(garbage));
+}
+
+static void testDropPartialFrame()
+{
+	MavlinkParser parser;
+	uint8_t payload[MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_LEN];
+	overridePayload(payload, 1700);
+
+	int length = mavlinkGenerateFrame(stream, 1, 0, 0, MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE,
+		MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_CRC, payload, sizeof(payload));
+
+	//A datagram cut short, then a whole frame in the next one
+	CHECK(feed(parser, stream, 20) == 0);
+	CHECK(parser.receiving());
+
+	parser.dropPartialFrame();
+	CHECK(!parser.receiving());
+	CHECK(feed(parser, stream, length) == 1);
+
+	mavlink_parser_stats_t stats = parser.getStats();
+	CHECK(stats.frames == 1);
+	CHECK(stats.droppedBytes == 20);
+	CHECK(stats.checksumErrors == 0);
+}
+
+int main()
+{
+	RUN_TEST(testBothVersions);
+	RUN_TEST(testTrimmedPayload);
+	RUN_TEST(testGarbageAndBadFrames);
+	RUN_TEST(testDropPartialFrame);
+
+	return hostTestResult();
+}
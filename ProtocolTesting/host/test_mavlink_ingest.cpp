@@ -0,0 +1,279 @@
+//MAVLink commands turned into emulator frames, from bytes and from loopback UDP datagrams
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "HostTest.h"
+#include "MockDriver.h"
+#include "MavlinkGenerator.h"
+#include "FlightControlEmulator.h"
+#include "MavlinkIngest.h"
+
+#define UNUSED_CHANNEL 0xFFFF
+#define INVALID_AXIS 0x7FFF
+
+static void writeWord(uint8_t * bytes, uint16_t value)
+{
+	bytes[0] = value & 0xFF;
+	bytes[1] = value >> 8;
+}
+
+//RC_CHANNELS_OVERRIDE for channels 1-6, every other channel ignored
+static int overrideFrame(uint8_t * out, uint8_t sequence, const uint16_t channels[6], uint8_t targetSystem)
+{
+	uint8_t payload[MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_LEN];
+	memset(payload, 0, sizeof(payload));
+
+	for(int i = 0; i < 8; i++)
+		writeWord(&payload[i * 2], i < 6 ? channels[i] : UNUSED_CHANNEL);
+
+	//target_component right after target_system, set to the system id so a wrong offset would pass
+	payload[16] = targetSystem;
+	payload[17] = 1;
+
+	return mavlinkGenerateFrame(out, 1, 0, sequence, MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE,
+		MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_CRC, payload, sizeof(payload));
+}
+
+//MANUAL_CONTROL with the x, y, z and r axes, as a v1 frame
+static int manualControlFrame(uint8_t * out, uint8_t sequence, int16_t x, int16_t y, int16_t z, int16_t r,
+	uint8_t targetSystem)
+{
+	uint8_t payload[MAVLINK_MSG_ID_MANUAL_CONTROL_LEN];
+	memset(payload, 0, sizeof(payload));
+
+	writeWord(&payload[0], x);
+	writeWord(&payload[2], y);
+	writeWord(&payload[4], z);
+	writeWord(&payload[6], r);
+
+	//buttons, set to the system id so a wrong offset would pass
+	writeWord(&payload[8], 0x0101);
+	payload[10] = targetSystem;
+
+	return mavlinkGenerateFrame(out, 0, 0, sequence, MAVLINK_MSG_ID_MANUAL_CONTROL, MAVLINK_MSG_ID_MANUAL_CONTROL_CRC,
+		payload, sizeof(payload));
+}
+
+static uint32_t frameSequence(FlightControlEmulator & controller)
+{
+	FlightFrame state;
+	CHECK(controller.getChannelState(state));
+	return state.sequence;
+}
+
+static void testOverrideScaling()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+
+	const float initial[6] = { 10, 20, 30, 40, 50, 60 };
+	CHECK(controller.setChannelFrame(initial, 0x3F) == FLIGHT_SUCCESS);
+
+	MavlinkIngest ingest(&controller, 1);
+	uint8_t frame[MAVLINK_HEADER_V2 + MAVLINK_MAX_PAYLOAD + 2 + MAVLINK_SIGNATURE_LENGTH];
+
+	//1000-2000 maps to 0-100%, 0 and UINT16_MAX leave the channel alone, out of range values clamp
+	const uint16_t channels[6] = { 1500, 2000, 0, UNUSED_CHANNEL, 900, 1250 };
+	uint32_t sequence = frameSequence(controller);
+	CHECK(ingest.parse(frame, overrideFrame(frame, 0, channels, 1)) == 1);
+	CHECK(frameSequence(controller) == sequence + 1);
+
+	FlightFrame state;
+	CHECK(controller.getChannelState(state));
+	CHECK_NEAR(state.values[0], 50, .001);
+	CHECK_NEAR(state.values[1], 100, .001);
+	CHECK_NEAR(state.values[2], 30, .001);
+	CHECK_NEAR(state.values[3], 40, .001);
+	CHECK_NEAR(state.values[4], 0, .001);
+	CHECK_NEAR(state.values[5], 25, .001);
+
+	//Every channel skipped is no command at all
+	const uint16_t skipped[6] = { 0, UNUSED_CHANNEL, 0, UNUSED_CHANNEL, 0, UNUSED_CHANNEL };
+	CHECK(ingest.parse(frame, overrideFrame(frame, 1, skipped, 1)) == 0);
+	CHECK(frameSequence(controller) == sequence + 1);
+
+	mavlink_ingest_stats_t stats = ingest.getStats();
+	CHECK(stats.frames == 2);
+	CHECK(stats.commands == 1);
+	CHECK(stats.rejected == 0);
+}
+
+static void testManualControlScaling()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+
+	const float initial[6] = { 10, 20, 30, 40, 50, 60 };
+	CHECK(controller.setChannelFrame(initial, 0x3F) == FLIGHT_SUCCESS);
+
+	MavlinkIngest ingest(&controller, 1);
+	uint8_t frame[MAVLINK_HEADER_V2 + MAVLINK_MAX_PAYLOAD + 2 + MAVLINK_SIGNATURE_LENGTH];
+
+	//x is pitch, y roll, z thrust 0-1000 and r yaw, the sticks are -1000 to 1000, 0x7FFF marks an unused axis
+	uint32_t sequence = frameSequence(controller);
+	CHECK(ingest.parse(frame, manualControlFrame(frame, 0, 500, -1000, 250, INVALID_AXIS, 1)) == 1);
+	CHECK(frameSequence(controller) == sequence + 1);
+
+	FlightFrame state;
+	CHECK(controller.getChannelState(state));
+	CHECK_NEAR(state.values[PWM_CHANNEL_ELEVATOR - 1], 75, .001);
+	CHECK_NEAR(state.values[PWM_CHANNEL_AILERON - 1], 0, .001);
+	CHECK_NEAR(state.values[PWM_CHANNEL_THROTTLE - 1], 25, .001);
+	CHECK_NEAR(state.values[PWM_CHANNEL_RUDDER - 1], 40, .001);
+	CHECK_NEAR(state.values[PWM_CHANNEL_AUX_A - 1], 50, .001);
+	CHECK_NEAR(state.values[PWM_CHANNEL_AUX_B - 1], 60, .001);
+
+	//Negative thrust clamps to 0 and a full stick to 100
+	CHECK(ingest.parse(frame, manualControlFrame(frame, 1, INVALID_AXIS, INVALID_AXIS, -300, 1000, 1)) == 1);
+	CHECK(controller.getChannelState(state));
+	CHECK_NEAR(state.values[PWM_CHANNEL_THROTTLE - 1], 0, .001);
+	CHECK_NEAR(state.values[PWM_CHANNEL_RUDDER - 1], 100, .001);
+	CHECK_NEAR(state.values[PWM_CHANNEL_ELEVATOR - 1], 75, .001);
+
+	//Every axis invalid is no command at all
+	CHECK(ingest.parse(frame, manualControlFrame(frame, 2, INVALID_AXIS, INVALID_AXIS, INVALID_AXIS, INVALID_AXIS, 1)) == 0);
+	CHECK(frameSequence(controller) == sequence + 2);
+}
+
+static void testTargetSystem()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+
+	MavlinkIngest ingest(&controller, 1);
+	uint8_t frame[MAVLINK_HEADER_V2 + MAVLINK_MAX_PAYLOAD + 2 + MAVLINK_SIGNATURE_LENGTH];
+	const uint16_t channels[6] = { 1500, 1500, 1500, 1500, 1500, 1500 };
+
+	//Addressed to system 2, the bytes around target_system are set to 1
+	uint32_t sequence = frameSequence(controller);
+	CHECK(ingest.parse(frame, overrideFrame(frame, 0, channels, 2)) == 0);
+	CHECK(ingest.parse(frame, manualControlFrame(frame, 1, 0, 0, 500, 0, 2)) == 0);
+	CHECK(frameSequence(controller) == sequence);
+	CHECK(ingest.getStats().rejected == 2);
+
+	//System id 0 takes commands for any system
+	MavlinkIngest any(&controller, 0);
+	CHECK(any.parse(frame, overrideFrame(frame, 2, channels, 2)) == 1);
+	CHECK(any.parse(frame, manualControlFrame(frame, 3, 0, 0, 500, 0, 7)) == 1);
+	CHECK(frameSequence(controller) == sequence + 2);
+}
+
+static void testOneCommitPerMessage()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+
+	MavlinkIngest ingest(&controller, 1);
+	uint8_t datagram[1024];
+	int length = 0;
+
+	//Several messages and a heartbeat in one datagram, each command is one commit of all its channels
+	const uint16_t channels[6] = { 1100, 1200, 1300, 1400, 1500, 1600 };
+	uint8_t heartbeat[MAVLINK_MSG_ID_HEARTBEAT_LEN] = { 0 };
+	length += overrideFrame(datagram + length, 0, channels, 1);
+	length += mavlinkGenerateFrame(datagram + length, 1, 0, 1, MAVLINK_MSG_ID_HEARTBEAT, MAVLINK_MSG_ID_HEARTBEAT_CRC,
+		heartbeat, sizeof(heartbeat));
+	length += manualControlFrame(datagram + length, 2, 0, 0, 1000, 0, 1);
+	length += overrideFrame(datagram + length, 3, channels, 1);
+
+	uint32_t sequence = frameSequence(controller);
+	CHECK(ingest.parse(datagram, length) == 3);
+	CHECK(frameSequence(controller) == sequence + 3);
+
+	mavlink_ingest_stats_t stats = ingest.getStats();
+	CHECK(stats.frames == 4);
+	CHECK(stats.commands == 3);
+}
+
+//Bind the receiver to a free loopback port
+static uint16_t openReceiver(MavlinkUdpReceiver & receiver)
+{
+	for(int attempt = 0; attempt < 32; attempt++)
+	{
+		uint16_t port = 20000 + (getpid() * 7 + attempt * 131) % 20000;
+		if(receiver.open(port))
+			return port;
+	}
+
+	return 0;
+}
+
+static void testUdpDrain()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+
+	MavlinkIngest ingest(&controller, 1);
+	MavlinkUdpReceiver receiver(&ingest);
+	uint16_t port = openReceiver(receiver);
+	CHECK(port != 0);
+
+	int sender = socket(AF_INET, SOCK_DGRAM, 0);
+	CHECK(sender >= 0);
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	//More than three batches, so the drain has to go round after full batches
+	const int datagrams = MAVLINK_UDP_BATCH * 3 + 5;
+	uint8_t frame[MAVLINK_HEADER_V2 + MAVLINK_MAX_PAYLOAD + 2 + MAVLINK_SIGNATURE_LENGTH];
+
+	for(int i = 0; i < datagrams; i++)
+	{
+		const uint16_t channels[6] = { (uint16_t) (1000 + i), 1500, 1500, 1500, 1500, 1500 };
+		int length = overrideFrame(frame, i, channels, 1);
+		CHECK(sendto(sender, frame, length, 0, (sockaddr *) &address, sizeof(address)) == length);
+	}
+
+	uint32_t sequence = frameSequence(controller);
+	CHECK(receiver.receive(1000) == datagrams);
+	CHECK(frameSequence(controller) == sequence + datagrams);
+
+	FlightFrame state;
+	CHECK(controller.getChannelState(state));
+	CHECK_NEAR(state.values[0], (datagrams - 1) * .1, .001);
+
+	//Nothing left
+	CHECK(receiver.receive(0) == 0);
+
+	//A datagram longer than a receive buffer starts with a valid frame, but is dropped whole
+	uint8_t oversized[MAVLINK_MAX_PAYLOAD + 100];
+	memset(oversized, 0, sizeof(oversized));
+	const uint16_t channels[6] = { 2000, 2000, 2000, 2000, 2000, 2000 };
+	overrideFrame(oversized, 0, channels, 1);
+	CHECK(sendto(sender, oversized, sizeof(oversized), 0, (sockaddr *) &address, sizeof(address)) == (int) sizeof(oversized));
+
+	CHECK(receiver.receive(1000) == 1);
+	CHECK(frameSequence(controller) == sequence + datagrams);
+
+	mavlink_ingest_stats_t stats = ingest.getStats();
+	CHECK(stats.truncatedDatagrams == 1);
+	CHECK(stats.commands == (uint32_t) datagrams);
+
+	close(sender);
+}
+
+int main()
+{
+	RUN_TEST(testOverrideScaling);
+	RUN_TEST(testManualControlScaling);
+	RUN_TEST(testTargetSystem);
+	RUN_TEST(testOneCommitPerMessage);
+	RUN_TEST(testUdpDrain);
+
+	return hostTestResult();
+}
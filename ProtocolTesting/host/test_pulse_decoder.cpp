@@ -0,0 +1,129 @@
+//Receiver pulse decoding from capture edges, and tear free statistics reads
+#include <pthread.h>
+#include <sched.h>
+#include "HostTest.h"
+#include "PulseDecoder.h"
+
+static void pulse(PulseDecoder & decoder, uint32_t riseTicks, uint32_t widthMicros, uint32_t nowMicros)
+{
+	decoder.onEdge(1, riseTicks, nowMicros);
+	decoder.onEdge(0, riseTicks + widthMicros * RECEIVER_TICKS_PER_US, nowMicros);
+}
+
+static void testValidPulses()
+{
+	PulseDecoder decoder;
+
+	CHECK(decoder.onEdge(1, 1000, 5) == 0);
+	CHECK(decoder.onEdge(0, 1000 + 1500 * RECEIVER_TICKS_PER_US, 6) == 1500);
+
+	pulse(decoder, 500000, 1000, 20);
+	pulse(decoder, 900000, 2000, 40);
+
+	receiver_channel_stats_t stats;
+	decoder.readStats(stats);
+	CHECK(stats.pulses == 3);
+	CHECK(stats.glitches == 0);
+	CHECK(stats.missedEdges == 0);
+	CHECK(stats.lastWidth == 2000);
+	CHECK(stats.minimumWidth == 1000);
+	CHECK(stats.maximumWidth == 2000);
+	CHECK(stats.lastPulseTime == 40);
+}
+
+static void testTimerWrap()
+{
+	PulseDecoder decoder;
+
+	//The capture timer wraps between the rising and falling edges
+	uint32_t rise = 0xFFFFFFFFu - 100 * RECEIVER_TICKS_PER_US;
+	CHECK(decoder.onEdge(1, rise, 0) == 0);
+	CHECK(decoder.onEdge(0, rise + 1200 * RECEIVER_TICKS_PER_US, 0) == 1200);
+}
+
+static void testGlitchesAndMissedEdges()
+{
+	PulseDecoder decoder;
+
+	pulse(decoder, 0, RECEIVER_PULSE_MINIMUM - 1, 1);
+	pulse(decoder, 0, RECEIVER_PULSE_MAXIMUM + 1, 2);
+
+	//A falling edge with no rising edge before it is ignored, two rising edges in a row count a missed edge
+	CHECK(decoder.onEdge(0, 1000, 3) == 0);
+	CHECK(decoder.onEdge(1, 1000, 4) == 0);
+	CHECK(decoder.onEdge(1, 2000, 5) == 0);
+	CHECK(decoder.onEdge(0, 2000 + 1100 * RECEIVER_TICKS_PER_US, 6) == 1100);
+
+	receiver_channel_stats_t stats;
+	decoder.readStats(stats);
+	CHECK(stats.pulses == 1);
+	CHECK(stats.glitches == 2);
+	CHECK(stats.missedEdges == 1);
+	CHECK(stats.lastWidth == 1100);
+
+	decoder.reset();
+	decoder.readStats(stats);
+	CHECK(stats.pulses == 0 && stats.glitches == 0 && stats.missedEdges == 0);
+	CHECK(stats.minimumWidth == 0xFFFF);
+}
+
+typedef struct
+{
+	PulseDecoder * decoder;
+	uint32_t pulses;
+	uint8_t done;
+} edge_args_t;
+
+static void * sendEdges(void * arg)
+{
+	edge_args_t * args = (edge_args_t *) arg;
+
+	//Every pulse is timestamped with its own width, so a torn read shows up as a mismatch
+	for(uint32_t i = 0; i < args->pulses; i++)
+	{
+		uint32_t width = i % 2 ? 1000 : 2000;
+		pulse(*args->decoder, i * 4000 * RECEIVER_TICKS_PER_US, width, width);
+
+		if(i % 64 == 0)
+			sched_yield();
+	}
+
+	__atomic_store_n(&args->done, 1, __ATOMIC_RELEASE);
+	return NULL;
+}
+
+static void testReadsNeverTear()
+{
+	PulseDecoder decoder;
+	edge_args_t args = { &decoder, 500000, 0 };
+
+	pthread_t writer;
+	CHECK(pthread_create(&writer, NULL, sendEdges, &args) == 0);
+
+	uint32_t reads = 0, torn = 0;
+
+	while(!__atomic_load_n(&args.done, __ATOMIC_ACQUIRE))
+	{
+		receiver_channel_stats_t stats;
+		decoder.readStats(stats);
+		reads++;
+
+		if(stats.pulses > 0 && stats.lastPulseTime != stats.lastWidth)
+			torn++;
+	}
+
+	pthread_join(writer, NULL);
+	printf("    %u reads racing %u pulses\n", reads, args.pulses);
+
+	CHECK(torn == 0);
+}
+
+int main()
+{
+	RUN_TEST(testValidPulses);
+	RUN_TEST(testTimerWrap);
+	RUN_TEST(testGlitchesAndMissedEdges);
+	RUN_TEST(testReadsNeverTear);
+
+	return hostTestResult();
+}
@@ -0,0 +1,185 @@
+//How the receiver is mixed into the emulated values: blending, takeover latching and release, and signal loss
+#include "HostTest.h"
+#include "MockDriver.h"
+#include "FlightControlEmulator.h"
+#include "ReceiverCapture.h"
+#include "VirtualClock.h"
+
+//Capture ticks keep counting between pulses like the real timer
+static uint32_t captureTicks = 0;
+
+//One pulse on the throttle capture input, channel 2 is unit 0 signal 1
+static void throttlePulse(float percentage)
+{
+	uint32_t width = RECEIVER_DEFAULT_LOW + (uint32_t) (percentage * (RECEIVER_DEFAULT_HIGH - RECEIVER_DEFAULT_LOW) / 100);
+
+	captureTicks += 1000 * RECEIVER_TICKS_PER_US;
+	mockDriverCaptureEdge(0, 1, 1, captureTicks);
+	captureTicks += width * RECEIVER_TICKS_PER_US;
+	mockDriverCaptureEdge(0, 1, 0, captureTicks);
+}
+
+static void testBlend()
+{
+	mockDriverReset();
+	VirtualClock clock(1000);
+	ReceiverCapture receiver;
+	receiver.setClock(&clock);
+	CHECK(receiver.init() == PWM_SUCCESS);
+	CHECK(receiver.setChannelMode(PWM_CHANNEL_THROTTLE, RECEIVER_BLEND, .25) == PWM_SUCCESS);
+
+	//Nothing to blend without signal
+	CHECK_NEAR(receiver.mix(PWM_CHANNEL_THROTTLE, 40), 40, .001);
+	CHECK(!receiver.isActive(PWM_CHANNEL_THROTTLE));
+
+	throttlePulse(80);
+	CHECK_NEAR(receiver.mix(PWM_CHANNEL_THROTTLE, 40), 80 * .25 + 40 * .75, .001);
+	CHECK(receiver.isActive(PWM_CHANNEL_THROTTLE));
+
+	//Channels left off never see the receiver
+	CHECK_NEAR(receiver.mix(PWM_CHANNEL_RUDDER, 40), 40, .001);
+}
+
+static void testTakeoverIgnoresRestingStick()
+{
+	mockDriverReset();
+	VirtualClock clock(1000);
+	ReceiverCapture receiver;
+	receiver.setClock(&clock);
+	CHECK(receiver.init() == PWM_SUCCESS);
+	CHECK(receiver.setChannelMode(PWM_CHANNEL_THROTTLE, RECEIVER_TAKEOVER) == PWM_SUCCESS);
+
+	//A throttle resting at 0%, far from centre, is not the pilot asking for control
+	for(int i = 0; i < 10; i++)
+	{
+		throttlePulse(0);
+		clock.advance(20000);
+		CHECK_NEAR(receiver.mix(PWM_CHANNEL_THROTTLE, 60), 60, .001);
+	}
+
+	CHECK(!receiver.isActive(PWM_CHANNEL_THROTTLE));
+	CHECK(receiver.isTracking(PWM_CHANNEL_THROTTLE));
+
+	//Noise inside the deadband does not latch either
+	throttlePulse(RECEIVER_TAKEOVER_DEADBAND - 1);
+	CHECK_NEAR(receiver.mix(PWM_CHANNEL_THROTTLE, 60), 60, .001);
+	CHECK(!receiver.isActive(PWM_CHANNEL_THROTTLE));
+}
+
+static void testTakeoverLatchesAndReleases()
+{
+	mockDriverReset();
+	VirtualClock clock(1000);
+	ReceiverCapture receiver;
+	receiver.setClock(&clock);
+	CHECK(receiver.init() == PWM_SUCCESS);
+	CHECK(receiver.setChannelMode(PWM_CHANNEL_THROTTLE, RECEIVER_TAKEOVER) == PWM_SUCCESS);
+
+	throttlePulse(0);
+	CHECK_NEAR(receiver.mix(PWM_CHANNEL_THROTTLE, 60), 60, .001);
+
+	//Moving the stick hands the channel to the pilot and it stays there wherever the stick goes
+	throttlePulse(30);
+	CHECK_NEAR(receiver.mix(PWM_CHANNEL_THROTTLE, 60), 30, .001);
+	CHECK(receiver.isActive(PWM_CHANNEL_THROTTLE));
+
+	throttlePulse(0);
+	CHECK_NEAR(receiver.mix(PWM_CHANNEL_THROTTLE, 60), 0, .001);
+
+	//Released with the stick held at 70%, that becomes the new rest
+	throttlePulse(70);
+	CHECK_NEAR(receiver.mix(PWM_CHANNEL_THROTTLE, 60), 70, .001);
+	receiver.releaseTakeover();
+	CHECK(!receiver.isActive(PWM_CHANNEL_THROTTLE));
+
+	throttlePulse(70);
+	CHECK_NEAR(receiver.mix(PWM_CHANNEL_THROTTLE, 60), 60, .001);
+	throttlePulse(72);
+	CHECK_NEAR(receiver.mix(PWM_CHANNEL_THROTTLE, 60), 60, .001);
+
+	throttlePulse(50);
+	CHECK_NEAR(receiver.mix(PWM_CHANNEL_THROTTLE, 60), 50, .001);
+	CHECK(receiver.isActive(PWM_CHANNEL_THROTTLE));
+
+	//Setting the mode again also starts over
+	CHECK(receiver.setChannelMode(PWM_CHANNEL_THROTTLE, RECEIVER_TAKEOVER) == PWM_SUCCESS);
+	CHECK_NEAR(receiver.mix(PWM_CHANNEL_THROTTLE, 60), 60, .001);
+	CHECK(!receiver.isActive(PWM_CHANNEL_THROTTLE));
+}
+
+static void testTakeoverSignalLoss()
+{
+	mockDriverReset();
+	VirtualClock clock(1000);
+	ReceiverCapture receiver;
+	receiver.setClock(&clock);
+	CHECK(receiver.init() == PWM_SUCCESS);
+	CHECK(receiver.setChannelMode(PWM_CHANNEL_THROTTLE, RECEIVER_TAKEOVER) == PWM_SUCCESS);
+
+	throttlePulse(0);
+	receiver.mix(PWM_CHANNEL_THROTTLE, 60);
+	throttlePulse(90);
+	CHECK_NEAR(receiver.mix(PWM_CHANNEL_THROTTLE, 60), 90, .001);
+
+	//A latched channel is still tracked after the signal goes, so mix can hand it back
+	clock.advance(RECEIVER_SIGNAL_TIMEOUT + 1);
+	CHECK(!receiver.isActive(PWM_CHANNEL_THROTTLE));
+	CHECK(receiver.isTracking(PWM_CHANNEL_THROTTLE));
+	CHECK_NEAR(receiver.mix(PWM_CHANNEL_THROTTLE, 60), 60, .001);
+	CHECK(!receiver.isTracking(PWM_CHANNEL_THROTTLE));
+
+	//The signal coming back with the stick where it was left does not take over again
+	throttlePulse(90);
+	CHECK_NEAR(receiver.mix(PWM_CHANNEL_THROTTLE, 60), 60, .001);
+	throttlePulse(90);
+	CHECK_NEAR(receiver.mix(PWM_CHANNEL_THROTTLE, 60), 60, .001);
+	CHECK(!receiver.isActive(PWM_CHANNEL_THROTTLE));
+}
+
+static void testPassthroughLatchesTakeover()
+{
+	mockDriverReset();
+	VirtualClock clock(1000);
+	FlightControlEmulator controller;
+	ReceiverCapture receiver;
+	controller.setClock(&clock);
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(receiver.init() == PWM_SUCCESS);
+	CHECK(receiver.setChannelMode(PWM_CHANNEL_THROTTLE, RECEIVER_TAKEOVER) == PWM_SUCCESS);
+	controller.setReceiver(&receiver);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+	CHECK(controller.setThrottle(30) == FLIGHT_SUCCESS);
+
+	FlightFrame state;
+
+	//Only updatePassthrough mixes between emulated changes, a resting stick keeps the emulated throttle
+	throttlePulse(0);
+	CHECK(controller.updatePassthrough() == FLIGHT_SUCCESS);
+	CHECK(controller.getChannelState(state));
+	CHECK_NEAR(state.values[PWM_CHANNEL_THROTTLE - 1], 30, .001);
+
+	throttlePulse(80);
+	CHECK(controller.updatePassthrough() == FLIGHT_SUCCESS);
+	CHECK(controller.getChannelState(state));
+	CHECK_NEAR(state.values[PWM_CHANNEL_THROTTLE - 1], 80, .001);
+
+	//Losing the signal puts the emulated throttle back
+	clock.advance(RECEIVER_SIGNAL_TIMEOUT + 1);
+	CHECK(controller.updatePassthrough() == FLIGHT_SUCCESS);
+	CHECK(controller.getChannelState(state));
+	CHECK_NEAR(state.values[PWM_CHANNEL_THROTTLE - 1], 30, .001);
+	CHECK(!receiver.isTracking(PWM_CHANNEL_THROTTLE));
+
+	controller.setReceiver(NULL);
+}
+
+int main()
+{
+	RUN_TEST(testBlend);
+	RUN_TEST(testTakeoverIgnoresRestingStick);
+	RUN_TEST(testTakeoverLatchesAndReleases);
+	RUN_TEST(testTakeoverSignalLoss);
+	RUN_TEST(testPassthroughLatchesTakeover);
+
+	return hostTestResult();
+}
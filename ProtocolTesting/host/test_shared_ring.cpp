@@ -0,0 +1,253 @@
+//Shared memory frame ring, publishing through SharedFrameBridge and reading through the C reader API
+#include <pthread.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+#include "HostTest.h"
+#include "SharedFrameBridge.h"
+
+static char ringName[64];
+
+static FlightFrame makeFrame(uint32_t sequence)
+{
+	FlightFrame frame = FlightFrame();
+	frame.sequence = sequence;
+	frame.timestamp = sequence * 18302ull;
+
+	for(int i = 0; i < 6; i++)
+	{
+		frame.values[i] = (float) (sequence % 1000) + i;
+		frame.dutys[i] = (float) (sequence % 100) * .1f + i;
+	}
+
+	return frame;
+}
+
+//A frame is consistent if every field was written for the same sequence number
+static uint8_t frameConsistent(const shared_frame_t & frame)
+{
+	FlightFrame expected = makeFrame(frame.sequence);
+
+	if(frame.timestamp != expected.timestamp)
+		return 0;
+
+	for(int i = 0; i < 6; i++)
+	{
+		if(frame.values[i] != expected.values[i] || frame.dutys[i] != expected.dutys[i])
+			return 0;
+	}
+
+	return 1;
+}
+
+static void testReaderProcess()
+{
+	const uint32_t frameCount = 2000;
+
+	SharedFrameBridge bridge(ringName);
+	CHECK(bridge.open() == SHARED_FRAME_SUCCESS);
+
+	int ready[2];
+	CHECK(pipe(ready) == 0);
+
+	pid_t child = fork();
+	if(child == 0)
+	{
+		//Reader process, checks every frame arrives once and in order
+		shared_frame_reader_t reader;
+		int status = shared_frame_reader_open(&reader, ringName) == 0 ? 0 : 2;
+		char byte = 1;
+		if(write(ready[1], &byte, 1) != 1)
+			_exit(3);
+
+		uint32_t expected = 1;
+		time_t deadline = time(NULL) + 10;
+
+		while(status == 0 && expected <= frameCount && time(NULL) < deadline)
+		{
+			shared_frame_t frame;
+			if(!shared_frame_reader_next(&reader, &frame))
+				continue;
+
+			if(frame.sequence != expected || frame.index != expected - 1 || !frameConsistent(frame))
+				status = 1;
+
+			expected++;
+		}
+
+		if(expected <= frameCount || reader.overruns != 0)
+			status = status ? status : 4;
+
+		shared_frame_reader_close(&reader);
+		_exit(status);
+	}
+
+	char byte;
+	CHECK(read(ready[0], &byte, 1) == 1);
+
+	//Publish in bursts shorter than the ring so the reader is never lapped
+	for(uint32_t sequence = 1; sequence <= frameCount; sequence++)
+	{
+		bridge.onFrameCommit(makeFrame(sequence));
+		if(sequence % (SHARED_FRAME_SLOTS / 2) == 0)
+			usleep(2000);
+	}
+
+	int status = -1;
+	waitpid(child, &status, 0);
+	CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+	close(ready[0]);
+	close(ready[1]);
+	bridge.remove();
+}
+
+static void testLappedReaderSkipsAhead()
+{
+	SharedFrameBridge bridge(ringName);
+	CHECK(bridge.open() == SHARED_FRAME_SUCCESS);
+
+	shared_frame_reader_t reader;
+	CHECK(shared_frame_reader_open(&reader, ringName) == 0);
+
+	for(uint32_t sequence = 1; sequence <= 200; sequence++)
+		bridge.onFrameCommit(makeFrame(sequence));
+
+	//The oldest frame still in the ring is the first one returned, everything before it is an overrun
+	shared_frame_t frame;
+	uint32_t read = 0;
+	uint64_t previous = 0;
+
+	while(shared_frame_reader_next(&reader, &frame))
+	{
+		CHECK(frameConsistent(frame));
+		CHECK(frame.sequence == frame.index + 1);
+		if(read > 0)
+			CHECK(frame.index == previous + 1);
+
+		previous = frame.index;
+		read++;
+	}
+
+	CHECK(read == SHARED_FRAME_SLOTS - 1);
+	CHECK(reader.overruns == 200 - (SHARED_FRAME_SLOTS - 1));
+	CHECK(previous == 199);
+
+	CHECK(shared_frame_reader_latest(&reader, &frame) == 1);
+	CHECK(frame.sequence == 200);
+
+	shared_frame_reader_close(&reader);
+	bridge.remove();
+}
+
+struct StressState
+{
+	SharedFrameBridge * bridge;
+	volatile uint8_t stop;
+};
+
+static void * stressWriter(void * arg)
+{
+	StressState * state = (StressState *) arg;
+
+	for(uint32_t sequence = 1; !state->stop; sequence++)
+		state->bridge->onFrameCommit(makeFrame(sequence));
+
+	return NULL;
+}
+
+static void testReaderRacingWriter()
+{
+	SharedFrameBridge bridge(ringName);
+	CHECK(bridge.open() == SHARED_FRAME_SUCCESS);
+
+	shared_frame_reader_t reader;
+	CHECK(shared_frame_reader_open(&reader, ringName) == 0);
+
+	StressState state;
+	state.bridge = &bridge;
+	state.stop = 0;
+
+	pthread_t writer;
+	pthread_create(&writer, NULL, stressWriter, &state);
+
+	//A writer flat out laps the reader constantly, every returned frame must still be the one its index names
+	uint32_t read = 0;
+	uint32_t bad = 0;
+	uint64_t expectedIndex = reader.nextIndex;
+
+	while(read < 200000)
+	{
+		shared_frame_t frame;
+		uint64_t overrunsBefore = reader.overruns;
+
+		if(!shared_frame_reader_next(&reader, &frame))
+			continue;
+
+		expectedIndex += reader.overruns - overrunsBefore;
+		if(frame.index != expectedIndex || frame.sequence != frame.index + 1 || !frameConsistent(frame))
+			bad++;
+
+		expectedIndex = frame.index + 1;
+		read++;
+	}
+
+	state.stop = 1;
+	pthread_join(writer, NULL);
+
+	printf("    %u frames read, %llu overruns\n", read, (unsigned long long) reader.overruns);
+	CHECK(bad == 0);
+
+	shared_frame_reader_close(&reader);
+	bridge.remove();
+}
+
+static void testReopenKeepsReaders()
+{
+	SharedFrameBridge * bridge = new SharedFrameBridge(ringName);
+	CHECK(bridge->open() == SHARED_FRAME_SUCCESS);
+
+	shared_frame_reader_t reader;
+	CHECK(shared_frame_reader_open(&reader, ringName) == 0);
+
+	for(uint32_t sequence = 1; sequence <= 5; sequence++)
+		bridge->onFrameCommit(makeFrame(sequence));
+
+	//A restarted publisher picks up where the last one stopped instead of resetting the ring
+	delete bridge;
+	bridge = new SharedFrameBridge(ringName);
+	CHECK(bridge->open() == SHARED_FRAME_SUCCESS);
+
+	for(uint32_t sequence = 6; sequence <= 10; sequence++)
+		bridge->onFrameCommit(makeFrame(sequence));
+
+	shared_frame_t frame;
+	uint32_t expected = 1;
+
+	while(shared_frame_reader_next(&reader, &frame))
+	{
+		CHECK(frame.sequence == expected);
+		expected++;
+	}
+
+	CHECK(expected == 11);
+	shared_frame_reader_close(&reader);
+
+	bridge->remove();
+	delete bridge;
+
+	CHECK(shared_frame_reader_open(&reader, ringName) == -1);
+}
+
+int main()
+{
+	snprintf(ringName, sizeof(ringName), "/fce_test_%d", (int) getpid());
+
+	RUN_TEST(testReaderProcess);
+	RUN_TEST(testLappedReaderSkipsAhead);
+	RUN_TEST(testReaderRacingWriter);
+	RUN_TEST(testReopenKeepsReaders);
+
+	return hostTestResult();
+}
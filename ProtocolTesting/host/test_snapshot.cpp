@@ -0,0 +1,261 @@
+//Resuming from a stored snapshot, file store rate limiting, and first start bookkeeping
+#include <stdio.h>
+#include <unistd.h>
+#include "HostTest.h"
+#include "MockDriver.h"
+#include "FlightControlEmulator.h"
+#include "VirtualClock.h"
+
+//Keeps the snapshot in memory, standing in for RTC memory across a reset
+class MemorySnapshotStore : public FlightSnapshotStore
+{
+public:
+	FlightSnapshot snapshot;
+	uint32_t saves;
+
+	MemorySnapshotStore() : saves(0) { this->snapshot.magic = 0; }
+
+	void save(const FlightSnapshot & snapshot) { this->snapshot = snapshot; this->saves++; }
+	uint8_t load(FlightSnapshot & snapshot) { snapshot = this->snapshot; return flightSnapshotValid(&snapshot); }
+	void clear() { this->snapshot.magic = 0; }
+};
+
+//Run a controller at 70% throttle and stop it by losing power, leaving a running snapshot behind
+static void flyAndReset(MemorySnapshotStore & store, VirtualClock & clock)
+{
+	mockDriverReset();
+	mockDriverSetClock(&clock);
+
+	FlightControlEmulator controller;
+	controller.setClock(&clock);
+	controller.setSnapshotStore(&store);
+	controller.init();
+	controller.start();
+	controller.setThrottle(70);
+	controller.pitch(.5f);
+	controller.waitForNextFrame();
+
+	mockDriverSetClock(NULL);
+}
+
+static void testResumeAppliesValuesBeforeFirstPulse()
+{
+	VirtualClock clock;
+	MemorySnapshotStore store;
+	flyAndReset(store, clock);
+
+	FlightFrame before;
+	CHECK(store.snapshot.running == 1);
+	CHECK_NEAR(store.snapshot.values[PWM_CHANNEL_THROTTLE - 1], 70, .001);
+
+	//Same configuration after the reset, the outputs come back exactly as they were
+	mockDriverReset();
+	mockDriverSetClock(&clock);
+	FlightControlEmulator controller;
+	controller.setClock(&clock);
+	controller.setSnapshotStore(&store);
+	controller.init();
+
+	CHECK(controller.hasResumableState());
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+	CHECK(controller.wasResumed());
+	CHECK(controller.getChannelState(before));
+	CHECK_NEAR(before.values[PWM_CHANNEL_THROTTLE - 1], 70, .001);
+	CHECK_NEAR(before.values[PWM_CHANNEL_ELEVATOR - 1], 75, .001);
+	CHECK_NEAR(before.dutys[PWM_CHANNEL_THROTTLE - 1], store.snapshot.dutys[PWM_CHANNEL_THROTTLE - 1], .0001);
+
+	//The throttle timer held the resumed duty before it started counting
+	const mock_timer_t & throttle = mockDriverTimer(0, 1);
+	CHECK(throttle.running);
+	CHECK(throttle.dutyTime <= throttle.startTime);
+
+	mockDriverSetClock(NULL);
+}
+
+static void testResumeAfterModeChange()
+{
+	VirtualClock clock;
+	MemorySnapshotStore store;
+	flyAndReset(store, clock);
+
+	//The new firmware drives the ESC with OneShot125, the stored servo duty would be a 46us pulse
+	mockDriverReset();
+	mockDriverSetClock(&clock);
+	FlightControlEmulator controller;
+	controller.setClock(&clock);
+	controller.setSnapshotStore(&store);
+	controller.init();
+	CHECK(controller.setThrottleMode(PWM_MODE_ONESHOT125) == FLIGHT_SUCCESS);
+
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+	CHECK(controller.wasResumed());
+
+	//70% of the 125-250us range at 2kHz
+	CHECK_NEAR(mockDriverTimer(0, 1).duty, (125 + 125 * .7) / 500 * 100, .01);
+
+	FlightFrame state;
+	CHECK(controller.getChannelState(state));
+	CHECK_NEAR(state.values[PWM_CHANNEL_THROTTLE - 1], 70, .001);
+
+	mockDriverSetClock(NULL);
+}
+
+static void testStopIsNotResumed()
+{
+	VirtualClock clock;
+	MemorySnapshotStore store;
+	mockDriverReset();
+
+	FlightControlEmulator controller;
+	controller.setClock(&clock);
+	controller.setSnapshotStore(&store);
+	controller.init();
+	controller.start();
+	controller.setThrottle(70);
+	controller.stop();
+
+	CHECK(store.snapshot.running == 0);
+	CHECK(!controller.hasResumableState());
+}
+
+static void testFileStoreRateLimit()
+{
+	char path[64];
+	snprintf(path, sizeof(path), "/tmp/fce_snapshot_%d", (int) getpid());
+
+	VirtualClock clock;
+	mockDriverReset();
+	FileSnapshotStore * store = new FileSnapshotStore(path);
+
+	FlightControlEmulator controller;
+	controller.setClock(&clock);
+	controller.setSnapshotStore(store);
+	controller.init();
+	controller.start();
+
+	//The start itself is written at once
+	FlightSnapshot onDisk;
+	FileSnapshotStore reader(path);
+	CHECK(reader.load(onDisk));
+	CHECK(onDisk.running == 1);
+	uint32_t startSequence = onDisk.sequence;
+
+	//Frames inside the interval are held back, the store itself still reports the newest
+	controller.setThrottle(10);
+	controller.setThrottle(20);
+	CHECK(reader.load(onDisk));
+	CHECK(onDisk.sequence == startSequence);
+
+	FlightSnapshot newest;
+	CHECK(store->load(newest));
+	CHECK(newest.sequence == startSequence + 2);
+
+	//Once the interval has passed the next frame reaches the file
+	clock.advance(FILE_SNAPSHOT_DEFAULT_INTERVAL_US);
+	controller.setThrottle(30);
+	CHECK(reader.load(onDisk));
+	CHECK(onDisk.sequence == startSequence + 3);
+	CHECK_NEAR(onDisk.values[PWM_CHANNEL_THROTTLE - 1], 30, .001);
+
+	//An hour of frames writes the file about ten times a second rather than every frame
+	uint32_t frames = 0;
+	uint64_t endTime = clock.now() + 3600000000ull;
+	uint32_t changes = 0;
+	uint32_t lastSequence = onDisk.sequence;
+
+	while(clock.now() < endTime)
+	{
+		controller.setThrottle(frames % 100);
+		controller.waitForNextFrame();
+		frames++;
+
+		if(frames % 50 == 0)
+		{
+			reader.load(onDisk);
+			changes += onDisk.sequence != lastSequence;
+			lastSequence = onDisk.sequence;
+		}
+	}
+
+	CHECK(changes > 0);
+
+	//Stopping always reaches the file
+	controller.setThrottle(42);
+	controller.stop();
+	CHECK(reader.load(onDisk));
+	CHECK(onDisk.running == 0);
+	CHECK_NEAR(onDisk.values[PWM_CHANNEL_THROTTLE - 1], 42, .001);
+
+	delete store;
+	reader.clear();
+}
+
+static void testFileStoreWriteCount()
+{
+	//Count writes through the file's modification, one per interval of snapshot time
+	char path[64];
+	snprintf(path, sizeof(path), "/tmp/fce_snapshot_count_%d", (int) getpid());
+
+	FileSnapshotStore store(path, 1000);
+	FileSnapshotStore reader(path);
+	FlightSnapshot snapshot = FlightSnapshot();
+	snapshot.running = 1;
+
+	uint32_t writes = 0;
+	uint32_t lastOnDisk = 0xFFFFFFFF;
+
+	for(uint32_t i = 0; i < 10000; i++)
+	{
+		snapshot.sequence = i;
+		snapshot.timestamp = i * 10;
+		flightSnapshotSeal(&snapshot);
+		store.save(snapshot);
+
+		FILE * file = fopen(path, "rb");
+		FlightSnapshot onDisk;
+		if(file != NULL && fread(&onDisk, sizeof(onDisk), 1, file) == 1 && onDisk.sequence != lastOnDisk)
+		{
+			writes++;
+			lastOnDisk = onDisk.sequence;
+		}
+		if(file != NULL)
+			fclose(file);
+	}
+
+	//100 ms of snapshot time at a 1 ms interval
+	CHECK(writes == 100);
+	store.clear();
+}
+
+static void testFirstStartAtClockZero()
+{
+	VirtualClock clock(0);
+	mockDriverReset();
+
+	FlightControlEmulator controller;
+	controller.setClock(&clock);
+	controller.init();
+
+	CHECK(!controller.hasStarted());
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+	CHECK(controller.hasStarted());
+	CHECK(controller.getFirstStartMicros() == 0);
+
+	//A later restart does not move the first start time
+	clock.advance(5000);
+	controller.stop();
+	controller.start();
+	CHECK(controller.getFirstStartMicros() == 0);
+}
+
+int main()
+{
+	RUN_TEST(testResumeAppliesValuesBeforeFirstPulse);
+	RUN_TEST(testResumeAfterModeChange);
+	RUN_TEST(testStopIsNotResumed);
+	RUN_TEST(testFileStoreRateLimit);
+	RUN_TEST(testFileStoreWriteCount);
+	RUN_TEST(testFirstStartAtClockZero);
+
+	return hostTestResult();
+}
@@ -0,0 +1,245 @@
+//Trace events recorded by the library, built with FCE_TRACE_ENABLED: the spans of one command, the core of each
+//event, and dumps taken while another thread records
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include "HostTest.h"
+#include "MockDriver.h"
+#include "FlightControlEmulator.h"
+#include "TraceRecorder.h"
+
+#ifndef FCE_TRACE_ENABLED
+#error test_trace has to be built with -DFCE_TRACE_ENABLED
+#endif
+
+typedef struct
+{
+	uint32_t timestamp;
+	uint32_t type;
+	char phase;
+	uint32_t arg;
+	uint32_t value;
+	uint32_t core;
+} dumped_event_t;
+
+static dumped_event_t dumped[FCE_TRACE_RING_SIZE];
+static uint32_t dumpedCount = 0;
+static uint32_t dumpedAnnounced = 0;
+static uint32_t malformedLines = 0;
+static uint8_t dumpEnded = 0;
+
+static void collectLine(const char * line)
+{
+	unsigned long timestamp, value;
+	unsigned int type, arg, core;
+	char phase;
+
+	if(strncmp(line, "TRACE BEGIN ", 12) == 0)
+		dumpedAnnounced = (uint32_t) strtoul(line + 12, NULL, 10);
+	else if(strcmp(line, "TRACE END") == 0)
+		dumpEnded = 1;
+	else if(sscanf(line, "T %lu %u %c %u %lu %u", &timestamp, &type, &phase, &arg, &value, &core) == 6 && dumpedCount < FCE_TRACE_RING_SIZE)
+		dumped[dumpedCount++] = { (uint32_t) timestamp, type, phase, arg, (uint32_t) value, core };
+	else
+		malformedLines++;
+}
+
+static void dumpTrace()
+{
+	dumpedCount = 0;
+	dumpedAnnounced = 0;
+	malformedLines = 0;
+	dumpEnded = 0;
+
+	TraceRecorder::dump(collectLine);
+}
+
+//Every end closes the latest open begin of the same event, and nothing is left open
+static uint8_t spansNest()
+{
+	uint32_t open[FCE_TRACE_RING_SIZE];
+	uint32_t depth = 0;
+
+	for(uint32_t i = 0; i < dumpedCount; i++)
+	{
+		if(dumped[i].phase == TRACE_PHASE_BEGIN)
+			open[depth++] = i;
+		else if(dumped[i].phase == TRACE_PHASE_END)
+		{
+			if(depth == 0 || dumped[open[depth - 1]].type != dumped[i].type || dumped[open[depth - 1]].arg != dumped[i].arg)
+				return 0;
+
+			depth--;
+		}
+	}
+
+	return depth == 0;
+}
+
+static void testCommandSpans()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+
+	TraceRecorder::clear();
+	CHECK(controller.setThrottle(40) == FLIGHT_SUCCESS);
+
+	FlightFrame state;
+	CHECK(controller.getChannelState(state));
+
+	dumpTrace();
+	CHECK(dumpEnded);
+	CHECK(malformedLines == 0);
+	CHECK(dumpedCount == dumpedAnnounced);
+	CHECK(dumpedCount > 4);
+	CHECK(spansNest());
+
+	//The command span wraps everything it did
+	CHECK(dumped[0].type == TRACE_EMULATOR_CALL && dumped[0].phase == TRACE_PHASE_BEGIN && dumped[0].arg == TRACE_CALL_THROTTLE);
+	CHECK(dumped[dumpedCount - 1].type == TRACE_EMULATOR_CALL && dumped[dumpedCount - 1].phase == TRACE_PHASE_END &&
+		dumped[dumpedCount - 1].arg == TRACE_CALL_THROTTLE);
+
+	//Then the throttle duty span, with every driver call ending in ESP_OK, and the frame commit last
+	CHECK(dumped[1].type == TRACE_SET_DUTY && dumped[1].phase == TRACE_PHASE_BEGIN && dumped[1].arg == PWM_CHANNEL_THROTTLE);
+
+	uint32_t dutyCalls = 0, commits = 0;
+	for(uint32_t i = 0; i < dumpedCount; i++)
+	{
+		if(dumped[i].type == TRACE_MCPWM_CALL && dumped[i].phase == TRACE_PHASE_END)
+			CHECK(dumped[i].value == ESP_OK);
+
+		if(dumped[i].type == TRACE_MCPWM_CALL && dumped[i].arg == TRACE_MCPWM_SET_DUTY && dumped[i].phase == TRACE_PHASE_BEGIN)
+			dutyCalls++;
+
+		if(dumped[i].type == TRACE_FRAME_COMMIT)
+		{
+			commits++;
+			CHECK(dumped[i].phase == TRACE_PHASE_INSTANT);
+			CHECK(dumped[i].value == state.sequence);
+			CHECK(i == dumpedCount - 2);
+		}
+
+		if(i > 0)
+			CHECK(dumped[i].timestamp >= dumped[i - 1].timestamp);
+
+		CHECK(dumped[i].core == 0);
+	}
+
+	CHECK(dutyCalls >= 1);
+	CHECK(commits == 1);
+}
+
+static void testCoreIds()
+{
+	mockDriverReset();
+	FlightControlEmulator controller;
+	CHECK(controller.init() == FLIGHT_SUCCESS);
+	CHECK(controller.start() == FLIGHT_SUCCESS);
+
+	//Commands from a task on the other core
+	mockRtosSetCoreId(1);
+	TraceRecorder::clear();
+	CHECK(controller.setThrottle(60) == FLIGHT_SUCCESS);
+	mockRtosSetCoreId(0);
+
+	dumpTrace();
+	CHECK(dumpedCount > 0);
+	for(uint32_t i = 0; i < dumpedCount; i++)
+		CHECK(dumped[i].core == 1);
+
+	//A parallel init prepares one unit from a task pinned to the other core
+	mockDriverReset();
+	FlightControlEmulator parallel;
+	parallel.setParallelInit(1);
+	TraceRecorder::clear();
+	CHECK(parallel.init() == FLIGHT_SUCCESS);
+
+	dumpTrace();
+	uint32_t perCore[2] = { 0, 0 };
+	for(uint32_t i = 0; i < dumpedCount; i++)
+	{
+		if(dumped[i].core < 2)
+			perCore[dumped[i].core]++;
+	}
+
+	CHECK(perCore[0] > 0);
+	CHECK(perCore[1] > 0);
+	CHECK(perCore[0] + perCore[1] == dumpedCount);
+}
+
+typedef struct
+{
+	uint32_t recorded;
+	uint8_t stop;
+} recorder_args_t;
+
+//Records events whose value can be worked out from the arg, so a torn event shows up in the dump
+static void * recordEvents(void * arg)
+{
+	recorder_args_t * args = (recorder_args_t *) arg;
+
+	for(uint32_t i = 0; !__atomic_load_n(&args->stop, __ATOMIC_ACQUIRE); i++)
+	{
+		uint16_t eventArg = (uint16_t) (i & 0x3FFF);
+		TraceRecorder::record(TRACE_BYTE_RX, TRACE_PHASE_INSTANT, eventArg, eventArg * 3u + 7);
+		args->recorded++;
+
+		if(i % 64 == 0)
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+static void testDumpWhileRecording()
+{
+	TraceRecorder::clear();
+
+	recorder_args_t args = { 0, 0 };
+	pthread_t recorder;
+	CHECK(pthread_create(&recorder, NULL, recordEvents, &args) == 0);
+
+	uint32_t torn = 0, events = 0;
+
+	for(int dump = 0; dump < 200; dump++)
+	{
+		dumpTrace();
+		CHECK(dumpEnded);
+		CHECK(malformedLines == 0);
+		CHECK(dumpedCount <= dumpedAnnounced);
+
+		for(uint32_t i = 0; i < dumpedCount; i++)
+		{
+			if(dumped[i].type != TRACE_BYTE_RX || dumped[i].phase != TRACE_PHASE_INSTANT || dumped[i].value != dumped[i].arg * 3 + 7)
+				torn++;
+		}
+
+		events += dumpedCount;
+		sched_yield();
+	}
+
+	__atomic_store_n(&args.stop, 1, __ATOMIC_RELEASE);
+	pthread_join(recorder, NULL);
+	printf("    %u events recorded, %u dumped over 200 dumps\n", args.recorded, events);
+
+	CHECK(torn == 0);
+	CHECK(events > 0);
+
+	//Recording carries on after a dump
+	TraceRecorder::clear();
+	TraceRecorder::record(TRACE_BYTE_RX, TRACE_PHASE_INSTANT, 1, 10);
+	dumpTrace();
+	CHECK(dumpedCount == 1);
+}
+
+int main()
+{
+	RUN_TEST(testCommandSpans);
+	RUN_TEST(testCoreIds);
+	RUN_TEST(testDumpWhileRecording);
+
+	return hostTestResult();
+}
@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+#Convert a TraceRecorder dump ("trace" command in SerialController) to Chrome trace JSON
+#
+#Usage: trace_to_chrome.py [dump.txt | -] [-o trace.json]
+#       trace_to_chrome.py --port /dev/ttyUSB0 [--baud 460800] [-o trace.json]
+#
+#Open the result in chrome://tracing or https://ui.perfetto.dev
+
+import argparse
+import json
+import sys
+
+EVENT_TYPES = ["byte_rx", "command_parse", "emulator_call", "set_duty", "mcpwm_call", "frame_commit"]
+
+CALL_NAMES = {
+    0: "idle", 1: "setThrottle", 2: "pitch", 3: "roll", 4: "yaw", 5: "resetControl", 6: "aux",
+    7: "setChannelFrame", 8: "updatePassthrough", 9: "start", 10: "stop",
+    32: "mcpwm_gpio_init", 33: "mcpwm_init", 34: "mcpwm_start", 35: "mcpwm_stop",
+    36: "mcpwm_set_duty", 37: "mcpwm_sync_enable", 38: "rmt_write_items", 39: "mcpwm_sync_disable",
+    40: "mcpwm_set_timer_sync_output", 41: "mcpwm_set_frequency", 42: "mcpwm_capture_enable",
+    43: "mcpwm_isr_register", 44: "rmt_config", 45: "rmt_driver_install", 46: "rmt_driver_uninstall",
+    47: "rmt_tx_stop", 48: "rmt_set_tx_loop_mode", 49: "rmt_wait_tx_done",
+    50: "rmt_fill_tx_items", 51: "rmt_tx_start"
+}
+
+
+def read_dump_lines(source):
+    started = False
+    for raw in source:
+        line = raw.decode(errors="replace") if isinstance(raw, bytes) else raw
+        line = line.strip()
+
+        if line.startswith("TRACE BEGIN"):
+            started = True
+        elif line == "TRACE END":
+            return
+        elif started and line.startswith("T "):
+            yield line
+
+
+def event_name(event_type, arg):
+    if event_type in (2, 4):
+        return CALL_NAMES.get(arg, "call_%d" % arg)
+    if event_type == 3:
+        return "setDuty ch%d" % arg
+    if event_type < len(EVENT_TYPES):
+        return EVENT_TYPES[event_type]
+    return "event_%d" % event_type
+
+
+def convert(lines):
+    events = []
+    cores = set()
+    previous = None
+    offset = 0
+
+    for line in lines:
+        fields = line.split()
+        if len(fields) not in (6, 7):
+            continue
+
+        timestamp, event_type, phase, arg, value = int(fields[1]), int(fields[2]), fields[3], int(fields[4]), int(fields[5])
+
+        #Each core gets its own track, dumps from before the core was recorded all go on core 0
+        core = int(fields[6]) if len(fields) == 7 else 0
+        cores.add(core)
+
+        #The recorder keeps the low 32 bits of the clock, so unwrap it
+        if previous is not None and timestamp < previous and previous - timestamp > 0x80000000:
+            offset += 1 << 32
+        previous = timestamp
+
+        event = {
+            "name": event_name(event_type, arg),
+            "cat": EVENT_TYPES[event_type] if event_type < len(EVENT_TYPES) else "unknown",
+            "ph": phase,
+            "ts": timestamp + offset,
+            "pid": 1,
+            "tid": core,
+        }
+
+        if phase == "i":
+            event["s"] = "t"
+        if phase != "B":
+            event["args"] = {"value": value}
+
+        events.append(event)
+
+    for core in sorted(cores):
+        events.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": core, "args": {"name": "core %d" % core}})
+
+    return {"traceEvents": events}
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Convert a TraceRecorder dump to Chrome trace JSON")
+    parser.add_argument("input", nargs="?", default="-", help="dump file, or - for stdin")
+    parser.add_argument("--port", help="read the dump from a serial port after sending the trace command")
+    parser.add_argument("--baud", type=int, default=460800)
+    parser.add_argument("-o", "--output", default="-", help="JSON output file, or - for stdout")
+    args = parser.parse_args()
+
+    if args.port:
+        import serial
+
+        with serial.Serial(args.port, args.baud, timeout=5) as port:
+            port.write(b"trace\n")
+            trace = convert(read_dump_lines(iter(port.readline, b"")))
+    elif args.input == "-":
+        trace = convert(read_dump_lines(sys.stdin))
+    else:
+        with open(args.input) as dump:
+            trace = convert(read_dump_lines(dump))
+
+    if args.output == "-":
+        json.dump(trace, sys.stdout)
+    else:
+        with open(args.output, "w") as out:
+            json.dump(trace, out)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,43 @@
+/*
+* Copyright (c) 2020 Lena Voytek
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <Arduino.h>
+#include "FlightControlEmulator.h"
+#include "MavlinkIngest.h"
+
+FlightControlEmulator controller;
+MavlinkIngest mavlink(&controller);
+
+void setup()
+{
+	Serial.begin(460800);
+
+	while (controller.init() != FLIGHT_SUCCESS || controller.start() != FLIGHT_SUCCESS)
+		delay(1000);
+}
+
+void loop()
+{
+	//Every RC_CHANNELS_OVERRIDE or MANUAL_CONTROL message from the ground station becomes one output frame
+	while(Serial.available())
+		mavlink.parse((uint8_t) Serial.read());
+}
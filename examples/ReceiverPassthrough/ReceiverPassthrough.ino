@@ -0,0 +1,61 @@
+/*
+* Copyright (c) 2020 Lena Voytek
+* 
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+* 
+* The above copyright notice and this permission notice shall be included in all
+* copies or substantial portions of the Software.
+* 
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+
+#include <Arduino.h>
+#include "FlightControlEmulator.h"
+#include "ReceiverCapture.h"
+
+FlightControlEmulator controller;
+ReceiverCapture receiver;
+
+void setup()
+{
+	Serial.begin(460800);
+
+	while (controller.init() != FLIGHT_SUCCESS || receiver.init() != PWM_SUCCESS)
+		delay(1000);
+
+	//The pilot flies the control surfaces, can take the throttle back by moving the stick, and shares the aux switches
+	receiver.setChannelMode(PWM_CHANNEL_AILERON, RECEIVER_PASSTHROUGH);
+	receiver.setChannelMode(PWM_CHANNEL_ELEVATOR, RECEIVER_PASSTHROUGH);
+	receiver.setChannelMode(PWM_CHANNEL_RUDDER, RECEIVER_PASSTHROUGH);
+	receiver.setChannelMode(PWM_CHANNEL_THROTTLE, RECEIVER_TAKEOVER);
+	receiver.setChannelMode(PWM_CHANNEL_AUX_A, RECEIVER_BLEND, .5);
+	receiver.setChannelMode(PWM_CHANNEL_AUX_B, RECEIVER_BLEND, .5);
+	controller.setReceiver(&receiver);
+
+	while (controller.start() != FLIGHT_SUCCESS)
+		delay(1000);
+}
+
+void loop()
+{
+	//Send "r" to hand a taken over throttle back to the emulator
+	if(Serial.available() && Serial.read() == 'r')
+		receiver.releaseTakeover();
+
+	//Apply the latest receiver pulses once per output frame
+	if(controller.updatePassthrough() != FLIGHT_SUCCESS)
+		Serial.println("Passthrough failed");
+
+	controller.waitForNextFrame();
+}
@@ -22,19 +22,40 @@
 
 #include <Arduino.h>
 #include "FlightControlEmulator.h"
+#include "ManeuverProgram.h"
+#include "ManeuverAssembler.h"
+#include "TraceRecorder.h"
 
 FlightControlEmulator controller;
+RtcSnapshotStore snapshotStore;
+ManeuverRunner maneuver(&controller);
+
+//The command being received, built up as bytes arrive so a running maneuver is never held up by the serial port
+String pendingCommand;
+
+//A command ends at a newline, or once no byte has arrived for this long so serial monitors sending no line ending
+//still work, the same timeout the blocking Serial.readString() used to wait out
+#define COMMAND_TIMEOUT_MS 2000
+unsigned long lastByteMillis = 0;
 
 void setup()
 {
 	Serial.begin(460800);
-	Serial.setTimeout(2000);
 
 	while (controller.init() != FLIGHT_SUCCESS)
 	{
 		Serial.println("Error: init failed");
 		delay(1000);
 	}
+
+	//Pick up where we left off after a watchdog or brownout reset
+	controller.setSnapshotStore(&snapshotStore);
+	if(controller.hasResumableState() && controller.start() == FLIGHT_SUCCESS)
+	{
+		Serial.print("Resumed outputs ");
+		Serial.print((unsigned long) controller.getFirstStartMicros());
+		Serial.println("us after reset");
+	}
 }
 
 float getSerialVal(String input)
@@ -49,13 +70,68 @@ float getSerialVal(String input)
 		return -100;
 }
 
+void stepManeuver()
+{
+	maneuver_state state = maneuver.step();
+	controller.waitForNextFrame();
+
+	if(state == MANEUVER_DONE)
+		Serial.println("Maneuver complete");
+	else if(state == MANEUVER_ABORTED)
+		Serial.println("Maneuver aborted");
+	else if(state == MANEUVER_ERROR)
+		Serial.println("Maneuver failed");
+}
+
+//Take whatever bytes have arrived without waiting for more, commands end with a newline or a pause in the bytes
+bool readCommand(String & command)
+{
+	//Mark the bytes as they arrive, before any of them are read
+	int available = Serial.available();
+	if(available > 0)
+		FCE_TRACE_INSTANT(TRACE_BYTE_RX, 0, available);
+
+	while(Serial.available())
+	{
+		char received = Serial.read();
+		lastByteMillis = millis();
+
+		if(received == '\n')
+		{
+			command = pendingCommand;
+			pendingCommand = "";
+			return true;
+		}
+
+		pendingCommand += received;
+	}
+
+	if(pendingCommand.length() > 0 && millis() - lastByteMillis >= COMMAND_TIMEOUT_MS)
+	{
+		command = pendingCommand;
+		pendingCommand = "";
+		return true;
+	}
+
+	return false;
+}
+
 void loop()
 {
-	String out = Serial.readString();
+	//Run the uploaded maneuver one frame at a time, picking up command bytes in between
+	if(maneuver.getState() == MANEUVER_RUNNING)
+		stepManeuver();
+
+	String out;
+	if(!readCommand(out))
+		return;
+
 	out.trim();
 
 	if(!out.isEmpty())
 	{
+		FCE_TRACE_SCOPE(TRACE_COMMAND_PARSE, 0);
+
 		if(out.equals("start"))
 		{
 			if(controller.start() == FLIGHT_SUCCESS)
@@ -84,6 +160,35 @@ void loop()
 			else
 				Serial.println("Control reset failed");
 		}
+		else if(out.startsWith("maneuver "))
+		{
+			//Statements are separated by ';', e.g. "maneuver ramp throttle 80 50; wait 50; set throttle 0"
+			uint8_t code[MANEUVER_PROGRAM_SIZE];
+			int length = maneuverAssemble(out.substring(9).c_str(), code, MANEUVER_PROGRAM_SIZE, NULL);
+
+			if(length >= 0 && maneuver.load(code, length) == MANEUVER_IDLE)
+				Serial.println("Maneuver load successful");
+			else
+				Serial.println("Maneuver load failed");
+		}
+		else if(out.equals("run"))
+		{
+			if(maneuver.start() == MANEUVER_RUNNING)
+				Serial.println("Maneuver started");
+			else
+				Serial.println("Maneuver start failed");
+		}
+		else if(out.equals("abort"))
+		{
+			maneuver.abort();
+			Serial.println("Maneuver aborted");
+		}
+		else if(out.equals("trace"))
+		{
+			//Feed the output to ProtocolTesting/trace_to_chrome.py, empty unless built with -DFCE_TRACE_ENABLED
+			TraceRecorder::dump([](const char * line) { Serial.println(line); });
+			TraceRecorder::clear();
+		}
 		else
 		{
 			if(out.startsWith("throttle"))
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "DShotEncoder.h"
+
+//Pack a high then low pulse into the layout of rmt_item32_t
+static uint32_t rmtSymbol(uint32_t highTicks, uint32_t lowTicks)
+{
+	return (highTicks & 0x7FFF) | (1u << 15) | ((lowTicks & 0x7FFF) << 16);
+}
+
+DShotEncoder::DShotEncoder(uint16_t kbitRate)
+{
+	if(kbitRate == 0)
+		kbitRate = 600;
+
+	//A 1 is high for three quarters of the bit period, a 0 for three eighths
+	uint32_t bitTicks = DSHOT_RMT_CLOCK_HZ / (kbitRate * 1000u);
+	uint32_t oneHigh = bitTicks * 3 / 4;
+	uint32_t zeroHigh = bitTicks * 3 / 8;
+
+	this->bitSymbols[0] = rmtSymbol(zeroHigh, bitTicks - zeroHigh);
+	this->bitSymbols[1] = rmtSymbol(oneHigh, bitTicks - oneHigh);
+
+	//Hold the line low for 16 bit periods between frames
+	uint32_t gapTicks = bitTicks * 8;
+	this->gapSymbol = (gapTicks & 0x7FFF) | ((gapTicks & 0x7FFF) << 16);
+}
+
+uint16_t DShotEncoder::packet(uint16_t value, uint8_t telemetry)
+{
+	uint16_t data = ((value & 0x7FF) << 1) | (telemetry ? 1 : 0);
+	uint16_t crc = (data ^ (data >> 4) ^ (data >> 8)) & 0x0F;
+
+	return (data << 4) | crc;
+}
+
+uint16_t DShotEncoder::throttleValue(float percentage)
+{
+	if(percentage <= 0)
+		return DSHOT_VALUE_DISARMED;
+
+	if(percentage >= 100)
+		return DSHOT_VALUE_MAXIMUM;
+
+	return DSHOT_VALUE_MINIMUM + (uint16_t) (percentage * (DSHOT_VALUE_MAXIMUM - DSHOT_VALUE_MINIMUM) * .01f + .5f);
+}
+
+void DShotEncoder::encode(uint16_t packet, uint32_t symbols[DSHOT_FRAME_SYMBOLS])
+{
+	for(int i = 0; i < DSHOT_FRAME_BITS; i++)
+		symbols[i] = this->bitSymbols[(packet >> (DSHOT_FRAME_BITS - 1 - i)) & 1];
+
+	symbols[DSHOT_FRAME_BITS] = this->gapSymbol;
+	symbols[DSHOT_FRAME_BITS + 1] = 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef DSHOTENCODER_H
+#define DSHOTENCODER_H
+
+#include <stdint.h>
+
+//RMT tick rate with the APB clock undivided
+#define DSHOT_RMT_CLOCK_HZ 80000000
+
+//16 data bits, the inter-frame gap, and the RMT end marker
+#define DSHOT_FRAME_BITS 16
+#define DSHOT_FRAME_SYMBOLS 18
+
+//Throttle values, 1-47 are reserved for ESC commands
+#define DSHOT_VALUE_DISARMED 0
+#define DSHOT_VALUE_MINIMUM 48
+#define DSHOT_VALUE_MAXIMUM 2047
+
+/**
+ * @brief Builds DShot frames as RMT item words, with the high and low timing of each bit value
+ * computed once at construction so encoding a frame is only table lookups
+ */
+class DShotEncoder
+{
+protected:
+	//RMT item words for a 0 bit and a 1 bit
+	uint32_t bitSymbols[2];
+
+	//RMT item word for the low gap between frames
+	uint32_t gapSymbol;
+
+public:
+	/**
+	 * @brief Precompute bit timing for a DShot rate
+	 * 
+	 * @param kbitRate The DShot bit rate in kbit/s, 150, 300 or 600
+	 */
+	DShotEncoder(uint16_t kbitRate);
+
+	/**
+	 * @brief Build the 16 bit packet for a value, 11 value bits, the telemetry request bit, and a 4 bit CRC
+	 * 
+	 * @param value The throttle value or command, 0-2047
+	 * @param telemetry 1 to request telemetry from the ESC
+	 * 
+	 * @return The packet, most significant bit first on the wire
+	 */
+	static uint16_t packet(uint16_t value, uint8_t telemetry);
+
+	/**
+	 * @brief Convert an RC output percentage to a DShot throttle value
+	 * 
+	 * @param percentage The output percentage, 0 disarms the motor
+	 * 
+	 * @return The throttle value
+	 */
+	static uint16_t throttleValue(float percentage);
+
+	/**
+	 * @brief Expand a packet into RMT items
+	 * 
+	 * @param packet The packet to send
+	 * @param symbols The DSHOT_FRAME_SYMBOLS RMT item words to fill
+	 */
+	void encode(uint16_t packet, uint32_t symbols[DSHOT_FRAME_SYMBOLS]);
+};
+
+#endif
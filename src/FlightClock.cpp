@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <Arduino.h>
+#include <esp_timer.h>
+#include "FlightClock.h"
+
+FlightClock * FlightClock::system()
+{
+	static SystemClock systemClock;
+	return &systemClock;
+}
+
+uint64_t SystemClock::now()
+{
+	return (uint64_t) esp_timer_get_time();
+}
+
+void SystemClock::sleepUntil(uint64_t timeMicros)
+{
+	uint64_t currentTime = this->now();
+
+	if(timeMicros <= currentTime)
+		return;
+
+	//Let other tasks run for the bulk of the wait, then spin for the remainder
+	uint64_t remaining = timeMicros - currentTime;
+	if(remaining > 2000)
+		delay((remaining - 1000) / 1000);
+
+	while(this->now() < timeMicros)
+		delayMicroseconds(1);
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef FLIGHTCLOCK_H
+#define FLIGHTCLOCK_H
+
+#include <stdint.h>
+
+/**
+ * @brief Source of time for every timing dependent part of the library, all values are in microseconds
+ */
+class FlightClock
+{
+public:
+	virtual ~FlightClock() {}
+
+	/**
+	 * @brief Get the current time
+	 * 
+	 * @return The number of microseconds since the clock started
+	 */
+	virtual uint64_t now() = 0;
+
+	/**
+	 * @brief Block until the given time has been reached, returns immediately if it already has
+	 * 
+	 * @param timeMicros The time to wait for
+	 */
+	virtual void sleepUntil(uint64_t timeMicros) = 0;
+
+	/**
+	 * @brief Block for the given amount of time
+	 * 
+	 * @param durationMicros The number of microseconds to wait
+	 */
+	void delayMicros(uint64_t durationMicros) { this->sleepUntil(this->now() + durationMicros); }
+
+	/**
+	 * @brief Get the shared clock backed by the hardware timer, used when no other clock is given
+	 */
+	static FlightClock * system();
+};
+
+
+/**
+ * @brief Clock backed by the ESP32 high resolution timer
+ */
+class SystemClock : public FlightClock
+{
+public:
+	uint64_t now();
+
+	void sleepUntil(uint64_t timeMicros);
+};
+
+#endif
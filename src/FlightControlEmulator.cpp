@@ -20,7 +20,10 @@
 * SOFTWARE.
 */
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
 #include "FlightControlEmulator.h"
+#include "TraceRecorder.h"
 FlightControlEmulator::FlightControlEmulator(FlightProtocol protocol)
 {
     this->activeProtocol = protocol;
@@ -34,14 +37,33 @@ FlightControlEmulator::FlightControlEmulator(FlightProtocol protocol)
     }
 
     for(int i = 0; i < 6; i++)
+    {
         this->currentValues[i] = 0;
+        this->outputValues[i] = 0;
+    }
+
+    this->frameListener = NULL;
+    this->frameSequence = 0;
+    this->stateLock = 0;
+    this->publishedState = FlightFrame();
+
+    this->receiver = NULL;
+    this->receiverActiveMask = 0;
+
+    this->snapshotStore = NULL;
+    this->running = 0;
+    this->resumed = 0;
+    this->firstStartTime = 0;
+    this->started = 0;
+
+    this->setClock(FlightClock::system());
 }
 
-FlightControlState FlightControlEmulator::init()
+FlightControlState FlightControlEmulator::init(uint8_t channelMask)
 {
     if(this->activeProtocol == PWM)
     {
-        if(this->pwm->init() == PWM_SUCCESS)
+        if(this->pwm->init(channelMask) == PWM_SUCCESS)
             return FLIGHT_SUCCESS;
     }
 
@@ -50,10 +72,40 @@ FlightControlState FlightControlEmulator::init()
 
 FlightControlState FlightControlEmulator::start()
 {
+    FCE_TRACE_SCOPE(TRACE_EMULATOR_CALL, TRACE_CALL_START);
+
     if(this->activeProtocol == PWM)
     {
-        if(this->idle() == FLIGHT_SUCCESS && this->pwm->start() == PWM_SUCCESS)
+        FlightSnapshot snapshot;
+        this->resumed = this->loadResumableSnapshot(snapshot);
+
+        //Load the last commanded values before starting so the first pulse is already correct, going through the
+        //current channel modes and rates since the stored dutys only fit the configuration they were taken under
+        if(this->resumed)
+        {
+            if(this->outputChannels(snapshot.values, this->readyChannels()) != PWM_SUCCESS)
+                return FLIGHT_PROTOCOL_FAILURE;
+
+            for(int i = 0; i < 6; i++)
+                this->currentValues[i] = snapshot.values[i];
+
+            this->frameSequence = snapshot.sequence;
+        }
+        else if(this->idle() != FLIGHT_SUCCESS)
+            return FLIGHT_PROTOCOL_FAILURE;
+
+        if(this->pwm->start() == PWM_SUCCESS)
+        {
+            if(!this->started)
+            {
+                this->firstStartTime = this->clock->now();
+                this->started = 1;
+            }
+
+            this->running = 1;
+            this->commitFrame();
             return FLIGHT_SUCCESS;
+        }
     }
 
     return FLIGHT_PROTOCOL_FAILURE;
@@ -61,10 +113,20 @@ FlightControlState FlightControlEmulator::start()
 
 FlightControlState FlightControlEmulator::stop()
 {
+    FCE_TRACE_SCOPE(TRACE_EMULATOR_CALL, TRACE_CALL_STOP);
+
     if(this->activeProtocol == PWM)
     {
         if(this->pwm->stop() == PWM_SUCCESS)
+        {
+            this->running = 0;
+            this->saveSnapshot(this->clock->now());
+
+            if(this->snapshotStore != NULL)
+                this->snapshotStore->flush();
+
             return FLIGHT_SUCCESS;
+        }
     }
 
     return FLIGHT_PROTOCOL_FAILURE;
@@ -72,14 +134,20 @@ FlightControlState FlightControlEmulator::stop()
 
 FlightControlState FlightControlEmulator::idle()
 {
+    FCE_TRACE_SCOPE(TRACE_EMULATOR_CALL, TRACE_CALL_IDLE);
+
     if(this->activeProtocol == PWM)
     {
-        if(this->pwm->setChannelOutputAllWithTypes(50, 50, 0, 50, this->currentValues[4], this->currentValues[5]) == PWM_SUCCESS)
+        float idleValues[6] = { 50, 50, 0, 50, this->currentValues[4], this->currentValues[5] };
+
+        //Channels deferred by init stay unconfigured until the application first drives them
+        if(this->outputChannels(idleValues, this->readyChannels()) == PWM_SUCCESS)
         {
             this->currentValues[0] = 50;
             this->currentValues[1] = 50;
             this->currentValues[2] = 0;
             this->currentValues[3] = 50;
+            this->commitFrame();
             return FLIGHT_SUCCESS;
         }
     }
@@ -89,6 +157,8 @@ FlightControlState FlightControlEmulator::idle()
 
 FlightControlState FlightControlEmulator::setThrottle(float throttleLevel)
 {
+    FCE_TRACE_SCOPE(TRACE_EMULATOR_CALL, TRACE_CALL_THROTTLE);
+
     if(this->activeProtocol == PWM)
     {
         if(!this->pwm->isInitialized())
@@ -97,8 +167,64 @@ FlightControlState FlightControlEmulator::setThrottle(float throttleLevel)
         if(throttleLevel < 0 || throttleLevel > 100)
             return FLIGHT_INVALID_INPUT;
 
-        if(this->pwm->setChannelOutput(PWM_CHANNEL_THROTTLE, throttleLevel) != PWM_SUCCESS)
+        if(this->outputChannel(PWM_CHANNEL_THROTTLE, throttleLevel) != PWM_SUCCESS)
             return FLIGHT_PROTOCOL_FAILURE;
+
+        this->currentValues[PWM_CHANNEL_THROTTLE - 1] = throttleLevel;
+        this->commitFrame();
+    }
+
+    return FLIGHT_SUCCESS;
+}
+
+FlightControlState FlightControlEmulator::setThrottleMode(pwm_output_mode mode)
+{
+    if(this->activeProtocol == PWM)
+    {
+        pwm_state result = this->pwm->setChannelMode(PWM_CHANNEL_THROTTLE, mode);
+        if(result == PWM_RATE_TOO_HIGH)
+            return FLIGHT_INVALID_INPUT;
+        else if(result != PWM_SUCCESS)
+            return FLIGHT_PROTOCOL_FAILURE;
+
+        //Reapply the current throttle in the new signal type
+        if(this->pwm->isInitialized())
+        {
+            if(this->outputChannel(PWM_CHANNEL_THROTTLE, this->currentValues[PWM_CHANNEL_THROTTLE - 1]) != PWM_SUCCESS)
+                return FLIGHT_PROTOCOL_FAILURE;
+
+            //Before start the stored snapshot is still needed for resume, start commits the first frame
+            if(this->running)
+                this->commitFrame();
+        }
+    }
+
+    return FLIGHT_SUCCESS;
+}
+
+FlightControlState FlightControlEmulator::setThrottleFrequency(uint32_t frequencyHz)
+{
+    if(frequencyHz == 0)
+        return FLIGHT_INVALID_INPUT;
+
+    if(this->activeProtocol == PWM)
+    {
+        uint32_t previousFrequency = this->pwm->getGroupFrequency(1);
+
+        pwm_state result = this->pwm->setGroupFrequency(1, frequencyHz);
+        if(result == PWM_SUCCESS)
+            result = this->pwm->setChannelGroup(PWM_CHANNEL_THROTTLE, 1);
+
+        //Leave the group at its old rate on any failure, a throttle pulse that does not fit in the new frame is
+        //reported as bad input
+        if(result != PWM_SUCCESS)
+        {
+            this->pwm->setGroupFrequency(1, previousFrequency);
+            return result == PWM_RATE_TOO_HIGH ? FLIGHT_INVALID_INPUT : FLIGHT_PROTOCOL_FAILURE;
+        }
+
+        if(this->running)
+            this->commitFrame();
     }
 
     return FLIGHT_SUCCESS;
@@ -106,6 +232,8 @@ FlightControlState FlightControlEmulator::setThrottle(float throttleLevel)
 
 FlightControlState FlightControlEmulator::pitch(float elevatorDir)
 {
+    FCE_TRACE_SCOPE(TRACE_EMULATOR_CALL, TRACE_CALL_PITCH);
+
     if(this->activeProtocol == PWM)
     {
         if(!this->pwm->isInitialized())
@@ -114,8 +242,11 @@ FlightControlState FlightControlEmulator::pitch(float elevatorDir)
         if(elevatorDir < -1 || elevatorDir > 1)
             return FLIGHT_INVALID_INPUT;
 
-        if(this->pwm->setChannelOutput(PWM_CHANNEL_ELEVATOR, (elevatorDir + 1) * 50) != PWM_SUCCESS)
+        if(this->outputChannel(PWM_CHANNEL_ELEVATOR, (elevatorDir + 1) * 50) != PWM_SUCCESS)
             return FLIGHT_PROTOCOL_FAILURE;
+
+        this->currentValues[PWM_CHANNEL_ELEVATOR - 1] = (elevatorDir + 1) * 50;
+        this->commitFrame();
     }
 
     return FLIGHT_SUCCESS;
@@ -123,6 +254,8 @@ FlightControlState FlightControlEmulator::pitch(float elevatorDir)
 
 FlightControlState FlightControlEmulator::roll(float aileronDir)
 {
+    FCE_TRACE_SCOPE(TRACE_EMULATOR_CALL, TRACE_CALL_ROLL);
+
     if(this->activeProtocol == PWM)
     {
         if(!this->pwm->isInitialized())
@@ -131,8 +264,11 @@ FlightControlState FlightControlEmulator::roll(float aileronDir)
         if(aileronDir < -1 || aileronDir > 1)
             return FLIGHT_INVALID_INPUT;
 
-        if(this->pwm->setChannelOutput(PWM_CHANNEL_AILERON, (aileronDir + 1) * 50) != PWM_SUCCESS)
+        if(this->outputChannel(PWM_CHANNEL_AILERON, (aileronDir + 1) * 50) != PWM_SUCCESS)
             return FLIGHT_PROTOCOL_FAILURE;
+
+        this->currentValues[PWM_CHANNEL_AILERON - 1] = (aileronDir + 1) * 50;
+        this->commitFrame();
     }
 
     return FLIGHT_SUCCESS;
@@ -140,6 +276,8 @@ FlightControlState FlightControlEmulator::roll(float aileronDir)
 
 FlightControlState FlightControlEmulator::yaw(float rudderDir)
 {
+    FCE_TRACE_SCOPE(TRACE_EMULATOR_CALL, TRACE_CALL_YAW);
+
     if(this->activeProtocol == PWM)
     {
         if(!this->pwm->isInitialized())
@@ -148,8 +286,11 @@ FlightControlState FlightControlEmulator::yaw(float rudderDir)
         if(rudderDir < -1 || rudderDir > 1)
             return FLIGHT_INVALID_INPUT;
 
-        if(this->pwm->setChannelOutput(PWM_CHANNEL_RUDDER, (rudderDir + 1) * 50) != PWM_SUCCESS)
+        if(this->outputChannel(PWM_CHANNEL_RUDDER, (rudderDir + 1) * 50) != PWM_SUCCESS)
             return FLIGHT_PROTOCOL_FAILURE;
+
+        this->currentValues[PWM_CHANNEL_RUDDER - 1] = (rudderDir + 1) * 50;
+        this->commitFrame();
     }
 
     return FLIGHT_SUCCESS;
@@ -157,19 +298,26 @@ FlightControlState FlightControlEmulator::yaw(float rudderDir)
 
 FlightControlState FlightControlEmulator::resetControl()
 {
+    FCE_TRACE_SCOPE(TRACE_EMULATOR_CALL, TRACE_CALL_RESET_CONTROL);
+
     if(this->activeProtocol == PWM)
     {
         if(!this->pwm->isInitialized())
             return FLIGHT_MODESWAP_FAILURE;
 
-        if(this->pwm->setChannelOutput(PWM_CHANNEL_ELEVATOR, 50) != PWM_SUCCESS)
+        if(this->outputChannel(PWM_CHANNEL_ELEVATOR, 50) != PWM_SUCCESS)
             return FLIGHT_PROTOCOL_FAILURE;
 
-        if(this->pwm->setChannelOutput(PWM_CHANNEL_AILERON, 50) != PWM_SUCCESS)
+        if(this->outputChannel(PWM_CHANNEL_AILERON, 50) != PWM_SUCCESS)
             return FLIGHT_PROTOCOL_FAILURE;
 
-        if(this->pwm->setChannelOutput(PWM_CHANNEL_RUDDER, 50) != PWM_SUCCESS)
+        if(this->outputChannel(PWM_CHANNEL_RUDDER, 50) != PWM_SUCCESS)
             return FLIGHT_PROTOCOL_FAILURE;
+
+        this->currentValues[PWM_CHANNEL_ELEVATOR - 1] = 50;
+        this->currentValues[PWM_CHANNEL_AILERON - 1] = 50;
+        this->currentValues[PWM_CHANNEL_RUDDER - 1] = 50;
+        this->commitFrame();
     }
 
     return FLIGHT_SUCCESS;
@@ -177,13 +325,18 @@ FlightControlState FlightControlEmulator::resetControl()
 
 FlightControlState FlightControlEmulator::activateAUX1()
 {
+    FCE_TRACE_SCOPE(TRACE_EMULATOR_CALL, TRACE_CALL_AUX);
+
     if(this->activeProtocol == PWM)
     {
         if(!this->pwm->isInitialized())
             return FLIGHT_MODESWAP_FAILURE;
 
-        if(this->pwm->setChannelOutput(PWM_CHANNEL_AUX_A, 100) != PWM_SUCCESS)
+        if(this->outputChannel(PWM_CHANNEL_AUX_A, 100) != PWM_SUCCESS)
             return FLIGHT_PROTOCOL_FAILURE;
+
+        this->currentValues[PWM_CHANNEL_AUX_A - 1] = 100;
+        this->commitFrame();
     }
 
     return FLIGHT_SUCCESS;
@@ -191,13 +344,18 @@ FlightControlState FlightControlEmulator::activateAUX1()
 
 FlightControlState FlightControlEmulator::activateAUX2()
 {
+    FCE_TRACE_SCOPE(TRACE_EMULATOR_CALL, TRACE_CALL_AUX);
+
     if(this->activeProtocol == PWM)
     {
         if(!this->pwm->isInitialized())
             return FLIGHT_MODESWAP_FAILURE;
 
-        if(this->pwm->setChannelOutput(PWM_CHANNEL_AUX_B, 100) != PWM_SUCCESS)
+        if(this->outputChannel(PWM_CHANNEL_AUX_B, 100) != PWM_SUCCESS)
             return FLIGHT_PROTOCOL_FAILURE;
+
+        this->currentValues[PWM_CHANNEL_AUX_B - 1] = 100;
+        this->commitFrame();
     }
 
     return FLIGHT_SUCCESS;
@@ -205,13 +363,18 @@ FlightControlState FlightControlEmulator::activateAUX2()
 
 FlightControlState FlightControlEmulator::deactivateAUX1()
 {
+    FCE_TRACE_SCOPE(TRACE_EMULATOR_CALL, TRACE_CALL_AUX);
+
     if(this->activeProtocol == PWM)
     {
         if(!this->pwm->isInitialized())
             return FLIGHT_MODESWAP_FAILURE;
 
-        if(this->pwm->setChannelOutput(PWM_CHANNEL_AUX_A, 0) != PWM_SUCCESS)
+        if(this->outputChannel(PWM_CHANNEL_AUX_A, 0) != PWM_SUCCESS)
             return FLIGHT_PROTOCOL_FAILURE;
+
+        this->currentValues[PWM_CHANNEL_AUX_A - 1] = 0;
+        this->commitFrame();
     }
 
     return FLIGHT_SUCCESS;
@@ -219,14 +382,287 @@ FlightControlState FlightControlEmulator::deactivateAUX1()
 
 FlightControlState FlightControlEmulator::deactivateAUX2()
 {
+    FCE_TRACE_SCOPE(TRACE_EMULATOR_CALL, TRACE_CALL_AUX);
+
+    if(this->activeProtocol == PWM)
+    {
+        if(!this->pwm->isInitialized())
+            return FLIGHT_MODESWAP_FAILURE;
+
+        if(this->outputChannel(PWM_CHANNEL_AUX_B, 0) != PWM_SUCCESS)
+            return FLIGHT_PROTOCOL_FAILURE;
+
+        this->currentValues[PWM_CHANNEL_AUX_B - 1] = 0;
+        this->commitFrame();
+    }
+
+    return FLIGHT_SUCCESS;
+}
+
+FlightControlState FlightControlEmulator::setChannelFrame(const float values[6], uint8_t channelMask)
+{
+    FCE_TRACE_SCOPE(TRACE_EMULATOR_CALL, TRACE_CALL_CHANNEL_FRAME);
+
     if(this->activeProtocol == PWM)
     {
         if(!this->pwm->isInitialized())
             return FLIGHT_MODESWAP_FAILURE;
 
-        if(this->pwm->setChannelOutput(PWM_CHANNEL_AUX_B, 0) != PWM_SUCCESS)
+        for(int i = 0; i < 6; i++)
+        {
+            if((channelMask & (1 << i)) && (values[i] < 0 || values[i] > 100))
+                return FLIGHT_INVALID_INPUT;
+        }
+
+        //All duties are worked out before any output changes, and the emulated values only change once all are out
+        if(this->outputChannels(values, channelMask) != PWM_SUCCESS)
             return FLIGHT_PROTOCOL_FAILURE;
+
+        for(int i = 0; i < 6; i++)
+        {
+            if(channelMask & (1 << i))
+                this->currentValues[i] = values[i];
+        }
+
+        this->commitFrame();
     }
 
     return FLIGHT_SUCCESS;
+}
+
+pwm_state FlightControlEmulator::outputChannel(int channel, float value)
+{
+    if(this->receiver != NULL)
+        value = this->receiver->mix(channel, value);
+
+    pwm_state result = this->pwm->setChannelOutput(channel, value);
+    if(result == PWM_SUCCESS)
+        this->outputValues[channel - 1] = value;
+
+    return result;
+}
+
+uint8_t FlightControlEmulator::readyChannels()
+{
+    uint8_t mask = 0;
+
+    for(int i = 0; i < 6; i++)
+    {
+        if(this->pwm->isChannelReady(i + 1))
+            mask |= 1 << i;
+    }
+
+    return mask;
+}
+
+pwm_state FlightControlEmulator::outputChannels(const float values[6], uint8_t channelMask)
+{
+    float mixed[6];
+
+    for(int i = 0; i < 6; i++)
+        mixed[i] = this->receiver != NULL && (channelMask & (1 << i)) ? this->receiver->mix(i + 1, values[i]) : values[i];
+
+    pwm_state result = this->pwm->setChannelOutputs(mixed, channelMask);
+    if(result != PWM_SUCCESS)
+        return result;
+
+    for(int i = 0; i < 6; i++)
+    {
+        if(channelMask & (1 << i))
+            this->outputValues[i] = mixed[i];
+    }
+
+    return PWM_SUCCESS;
+}
+
+FlightControlState FlightControlEmulator::updatePassthrough()
+{
+    FCE_TRACE_SCOPE(TRACE_EMULATOR_CALL, TRACE_CALL_PASSTHROUGH);
+
+    if(this->receiver == NULL)
+        return FLIGHT_SUCCESS;
+
+    if(this->activeProtocol == PWM)
+    {
+        if(!this->pwm->isInitialized())
+            return FLIGHT_MODESWAP_FAILURE;
+
+        uint8_t trackMask = 0;
+        float previousDutys[6];
+
+        //Takeover channels that have not latched yet are mixed too, so moving the stick can latch them
+        for(int i = 0; i < 6; i++)
+        {
+            if(this->receiver->isTracking(i + 1))
+                trackMask |= 1 << i;
+
+            previousDutys[i] = this->pwm->getDuty(i + 1);
+        }
+
+        //Channels that just lost the receiver go back to their emulated value
+        uint8_t updateMask = trackMask | this->receiverActiveMask;
+
+        if(updateMask != 0 && this->outputChannels(this->currentValues, updateMask) != PWM_SUCCESS)
+            return FLIGHT_PROTOCOL_FAILURE;
+
+        uint8_t activeMask = 0;
+        uint8_t changed = 0;
+        for(int i = 0; i < 6; i++)
+        {
+            if(this->receiver->isActive(i + 1))
+                activeMask |= 1 << i;
+
+            if(this->pwm->getDuty(i + 1) != previousDutys[i])
+                changed = 1;
+        }
+
+        this->receiverActiveMask = activeMask;
+
+        if(changed)
+            this->commitFrame();
+    }
+
+    return FLIGHT_SUCCESS;
+}
+
+void FlightControlEmulator::setReceiver(ReceiverCapture * receiver)
+{
+    this->receiver = receiver;
+    this->receiverActiveMask = 0;
+
+    if(receiver != NULL)
+        receiver->setClock(this->clock);
+}
+
+void FlightControlEmulator::setClock(FlightClock * clock)
+{
+    if(clock == NULL)
+        clock = FlightClock::system();
+
+    this->clock = clock;
+    this->nextFrameTime = clock->now();
+    this->frameCount = 0;
+
+    this->pwm->setClock(clock);
+    if(this->receiver != NULL)
+        this->receiver->setClock(clock);
+
+    TraceRecorder::setClock(clock);
+}
+
+uint32_t FlightControlEmulator::getFramePeriodMicros()
+{
+    return PWM_DEFAULT_PERIOD_US;
+}
+
+void FlightControlEmulator::waitForNextFrame()
+{
+    this->nextFrameTime += this->getFramePeriodMicros();
+
+    //Skip frames that were missed entirely rather than bursting to catch up
+    uint64_t currentTime = this->clock->now();
+    if(this->nextFrameTime < currentTime)
+        this->nextFrameTime = currentTime;
+
+    this->clock->sleepUntil(this->nextFrameTime);
+    this->frameCount++;
+}
+
+void FlightControlEmulator::commitFrame()
+{
+    this->frameSequence++;
+    FCE_TRACE_INSTANT(TRACE_FRAME_COMMIT, 0, this->frameSequence);
+
+    //Gather the frame first so readers are only held off for the copy
+    FlightFrame frame;
+    frame.sequence = this->frameSequence;
+    frame.timestamp = this->clock->now();
+
+    for(int i = 0; i < 6; i++)
+    {
+        frame.values[i] = this->outputValues[i];
+        frame.dutys[i] = this->pwm->getDuty(i + 1);
+    }
+
+    //Sequence lock writer, readers retry while the lock is odd or changed during their copy
+    uint32_t lock = this->stateLock;
+    __atomic_store_n(&this->stateLock, lock + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    this->publishedState = frame;
+
+    __atomic_store_n(&this->stateLock, lock + 2, __ATOMIC_RELEASE);
+
+    this->saveSnapshot(this->publishedState.timestamp);
+
+    if(this->frameListener != NULL)
+        this->frameListener->onFrameCommit(this->publishedState);
+}
+
+uint8_t FlightControlEmulator::getChannelState(FlightFrame & state)
+{
+    //An ISR that interrupted the commit would wait forever, so only tasks wait for the writer
+    uint8_t inIsr = xPortInIsrContext();
+
+    for(uint32_t attempt = 1; ; attempt++)
+    {
+        uint32_t before = __atomic_load_n(&this->stateLock, __ATOMIC_ACQUIRE);
+
+        if(!(before & 1))
+        {
+            state = this->publishedState;
+
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if(__atomic_load_n(&this->stateLock, __ATOMIC_RELAXED) == before)
+                return 1;
+        }
+
+        if(inIsr)
+        {
+            if(attempt >= FLIGHT_STATE_READ_ATTEMPTS)
+                return 0;
+        }
+        else if(attempt < FLIGHT_STATE_READ_ATTEMPTS)
+            taskYIELD();
+        else
+        {
+            //The writer may be a lower priority task preempted on this core, which a yield would not run
+            vTaskDelay(1);
+        }
+    }
+}
+
+void FlightControlEmulator::saveSnapshot(uint64_t timestamp)
+{
+    if(this->snapshotStore == NULL)
+        return;
+
+    FlightSnapshot snapshot;
+    snapshot.protocol = this->activeProtocol;
+    snapshot.running = this->running;
+    snapshot.sequence = this->frameSequence;
+    snapshot.timestamp = timestamp;
+
+    for(int i = 0; i < 6; i++)
+    {
+        snapshot.values[i] = this->currentValues[i];
+        snapshot.dutys[i] = this->pwm->getDuty(i + 1);
+    }
+
+    flightSnapshotSeal(&snapshot);
+    this->snapshotStore->save(snapshot);
+}
+
+uint8_t FlightControlEmulator::loadResumableSnapshot(FlightSnapshot & snapshot)
+{
+    if(this->snapshotStore == NULL || !this->snapshotStore->load(snapshot))
+        return 0;
+
+    return snapshot.running && snapshot.protocol == this->activeProtocol;
+}
+
+uint8_t FlightControlEmulator::hasResumableState()
+{
+    FlightSnapshot snapshot;
+    return this->loadResumableSnapshot(snapshot);
 }
\ No newline at end of file
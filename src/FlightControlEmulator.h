@@ -24,6 +24,14 @@
 #define FLIGHTCONTROLEMULATOR_H
 
 #include "PWMHandler.h"
+#include "FlightClock.h"
+#include "FlightFrame.h"
+#include "FlightSnapshot.h"
+#include "ReceiverCapture.h"
+
+//Number of times getChannelState retries a copy torn by the writer before giving up in an ISR, or before a task
+//starts sleeping between retries
+#define FLIGHT_STATE_READ_ATTEMPTS 16
 
 /**
  * @brief The communication protocol for flight control
@@ -56,9 +64,100 @@ protected:
     //The protocol currently in use
     FlightProtocol activeProtocol;
 
-    //The current percentages for all channels
+    //The current emulated percentages for all channels, before any receiver mix
     float currentValues[6];
 
+    //The percentages last output on each channel, after the receiver mix
+    float outputValues[6];
+
+    //The source of time for frame pacing
+    FlightClock * clock;
+
+    //The time at which the next output frame begins
+    uint64_t nextFrameTime;
+
+    //The number of frames waited on since the clock was set
+    uint64_t frameCount;
+
+    //Receiver of committed frames, may be null
+    FlightFrameListener * frameListener;
+
+    //The sequence number of the last committed frame
+    uint32_t frameSequence;
+
+    //Sequence lock guarding publishedState, odd while a commit is being written
+    uint32_t stateLock;
+
+    //Copy of the last committed frame for getChannelState
+    FlightFrame publishedState;
+
+    /**
+     * @brief Publish the current outputs to getChannelState readers, the snapshot store, and the frame listener
+     */
+    void commitFrame();
+
+    //Receiver mixed into the outputs, may be null
+    ReceiverCapture * receiver;
+
+    //Bitmask of channels the receiver contributed to at the last passthrough update
+    uint8_t receiverActiveMask;
+
+    /**
+     * @brief Output a channel value through the receiver mix
+     * 
+     * @param channel The channel, 1-6
+     * @param value The emulated output percentage
+     * 
+     * @return The result of the protocol output
+     */
+    pwm_state outputChannel(int channel, float value);
+
+    /**
+     * @brief Output several channel values through the receiver mix in one batch
+     * 
+     * @param values The emulated output percentages of all six channels, in channel order
+     * @param channelMask Bit n-1 set to output channel n
+     * 
+     * @return The result of the protocol output
+     */
+    pwm_state outputChannels(const float values[6], uint8_t channelMask);
+
+    /**
+     * @brief Get a mask of the channels the protocol has configured, bit n-1 for channel n
+     */
+    uint8_t readyChannels();
+
+    //Where controller state is kept across resets, may be null
+    FlightSnapshotStore * snapshotStore;
+
+    //States whether or not the outputs are started
+    uint8_t running;
+
+    //States whether or not the last start resumed from a snapshot
+    uint8_t resumed;
+
+    //Clock time at which outputs were first started, and whether they have been
+    uint64_t firstStartTime;
+    uint8_t started;
+
+    /**
+     * @brief Write the current state to the snapshot store
+     * 
+     * @param timestamp The clock time to record in the snapshot
+     */
+    void saveSnapshot(uint64_t timestamp);
+
+    /**
+     * @brief Load the stored snapshot if it is valid and was taken while running the active protocol
+     * 
+     * @param snapshot Where to copy the snapshot
+     * 
+     * @return
+     *     - 1 the snapshot can be resumed from
+     *     - 0 there is nothing to resume
+     */
+    uint8_t loadResumableSnapshot(FlightSnapshot & snapshot);
+
 public:
     /**
      * @brief Initializes the controller with a given protocol along with the default pins for it
@@ -79,10 +178,23 @@ public:
      *     - FLIGHT_SUCCESS the initialization was successful
      *     - FLIGHT_PROTOCOL_FAILURE the initialization failed
      */
-    FlightControlState init();
+    FlightControlState init() { return this->init(0x3F); }
 
     /**
-     * @brief Activates the protocol in the idle, ready for takeoff state
+     * @brief Initializes only the given channels, the rest stay unconfigured through start() and idle() until
+     * they are first driven
+     * 
+     * @param channelMask Bit n-1 set to initialize channel n immediately
+     * 
+     * @return
+     *     - FLIGHT_SUCCESS the initialization was successful
+     *     - FLIGHT_PROTOCOL_FAILURE the initialization failed
+     */
+    FlightControlState init(uint8_t channelMask);
+
+    /**
+     * @brief Activates the protocol in the idle, ready for takeoff state, or at the last commanded values if
+     * the snapshot store holds a valid snapshot taken while running, channels deferred by init are left alone
      * 
      * @return
      *     - FLIGHT_SUCCESS the activation was successful
@@ -122,6 +234,32 @@ public:
      */
     FlightControlState setThrottle(float throttleLevel);
 
+    /**
+     * @brief Sets the signal type of the throttle channel, ESC modes update at their own rate independently of
+     * the servo channels
+     * 
+     * @param mode The signal type to output on the throttle channel
+     * 
+     * @return
+     *     - FLIGHT_SUCCESS the mode change was successful
+     *     - FLIGHT_INVALID_INPUT a servo throttle pulse does not fit in its group frame
+     *     - FLIGHT_PROTOCOL_FAILURE The protocol ran into an error
+     */
+    FlightControlState setThrottleMode(pwm_output_mode mode);
+
+    /**
+     * @brief Runs the throttle channel in its own group at the given servo frame rate, leaving the control
+     * surface channels at the default rate
+     * 
+     * @param frequencyHz The throttle frame rate
+     * 
+     * @return
+     *     - FLIGHT_SUCCESS the rate change was successful
+     *     - FLIGHT_INVALID_INPUT the rate is 0 or too high for the longest throttle pulse to fit in a frame
+     *     - FLIGHT_PROTOCOL_FAILURE The protocol ran into an error
+     */
+    FlightControlState setThrottleFrequency(uint32_t frequencyHz);
+
     /**
      * @brief Sets the elevator direction for planes / upward acceleration for drones
      * 
@@ -216,6 +354,141 @@ public:
      */
     FlightControlState deactivateAUX2();
 
+    /**
+     * @brief Sets the output percentage of several channels as a single committed frame
+     * 
+     * @param values The output percentages of all six channels, in channel order
+     * @param channelMask Bit n-1 set to change channel n, other channels keep their current values
+     * 
+     * @return
+     *     - FLIGHT_SUCCESS the frame was committed
+     *     - FLIGHT_MODESWAP_FAILURE the frame failed as the controller is not initialized
+     *     - FLIGHT_INVALID_INPUT a percentage outside 0-100 was given, no change
+     *     - FLIGHT_PROTOCOL_FAILURE The protocol ran into an error
+     */
+    FlightControlState setChannelFrame(const float values[6], uint8_t channelMask);
+
+    /**
+     * @brief Set a receiver to mix with or take over from the emulated values, per the receiver's channel modes
+     * 
+     * @param receiver The initialized receiver capture, or null to output only emulated values
+     */
+    void setReceiver(ReceiverCapture * receiver);
+
+    /**
+     * @brief Apply the latest receiver pulses to the outputs, call at least once per frame to keep
+     * input to output latency under one frame
+     * 
+     * @return
+     *     - FLIGHT_SUCCESS the outputs are up to date
+     *     - FLIGHT_MODESWAP_FAILURE the controller is not initialized
+     *     - FLIGHT_PROTOCOL_FAILURE The protocol ran into an error
+     */
+    FlightControlState updatePassthrough();
+
+    /**
+     * @brief Set the clock used for frame pacing, use a VirtualClock to simulate time, the clock is also passed on
+     * to the PWM handler, the receiver, and trace timestamps
+     * 
+     * @param clock The clock to use, the system clock is used if null
+     */
+    void setClock(FlightClock * clock);
+
+    /**
+     * @brief Have init bring up the two MCPWM units on both cores at once
+     * 
+     * @param enabled 1 to initialize the units in parallel, 0 to initialize them one after the other
+     */
+    void setParallelInit(uint8_t enabled) { this->pwm->setParallelInit(enabled); }
+
+    /**
+     * @brief Get the clock used for frame pacing
+     * 
+     * @return The active clock
+     */
+    FlightClock * getClock() { return this->clock; }
+
+    /**
+     * @brief Get the length of one output frame of the active protocol
+     * 
+     * @return The frame period in microseconds
+     */
+    uint32_t getFramePeriodMicros();
+
+    /**
+     * @brief Block until the start of the next output frame
+     */
+    void waitForNextFrame();
+
+    /**
+     * @brief Get the number of frames waited on since the clock was set
+     * 
+     * @return The frame count
+     */
+    uint64_t getFrameCount() { return this->frameCount; }
+
+    /**
+     * @brief Set the receiver of every committed output frame
+     * 
+     * @param listener The listener to notify, or null to stop notifying
+     */
+    void setFrameListener(FlightFrameListener * listener) { this->frameListener = listener; }
+
+    /**
+     * @brief Copy the last committed channel values after the receiver mix, dutys and frame sequence number
+     * without locking, safe to call from any task or ISR
+     * @note A task waits for a commit in progress to finish, an ISR gives up after FLIGHT_STATE_READ_ATTEMPTS tries
+     * 
+     * @param state Where to copy the state
+     * 
+     * @return
+     *     - 1 the copy is consistent
+     *     - 0 a commit was in progress for every attempt, only possible from an ISR that interrupted the commit
+     */
+    uint8_t getChannelState(FlightFrame & state);
+
+    /**
+     * @brief Set where controller state is kept so start() can resume after a reset
+     * 
+     * @param store The snapshot store, or null to stop saving snapshots
+     */
+    void setSnapshotStore(FlightSnapshotStore * store) { this->snapshotStore = store; }
+
+    /**
+     * @brief State whether or not start() will resume from a stored snapshot
+     * 
+     * @return
+     *     - 1 a valid snapshot taken while running is stored
+     *     - 0 start() will begin at idle
+     */
+    uint8_t hasResumableState();
+
+    /**
+     * @brief State whether or not the last start() resumed from a stored snapshot
+     * 
+     * @return
+     *     - 1 outputs resumed at the snapshot values
+     *     - 0 outputs started at idle
+     */
+    uint8_t wasResumed() { return this->resumed; }
+
+    /**
+     * @brief Get the clock time at which outputs were first started, with the system clock this is the time
+     * from reset to the first valid pulse
+     * 
+     * @return The time in microseconds, only meaningful once hasStarted() is 1
+     */
+    uint64_t getFirstStartMicros() { return this->firstStartTime; }
+
+    /**
+     * @brief State whether or not the outputs have ever been started
+     * 
+     * @return
+     *     - 1 getFirstStartMicros holds the first start time
+     *     - 0 start() has not succeeded yet
+     */
+    uint8_t hasStarted() { return this->started; }
+
 };
 
 
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "FlightDynamics.h"
+
+FlightDynamics::FlightDynamics(int vehicleCount)
+{
+	if(vehicleCount < 1)
+		vehicleCount = 1;
+
+	this->vehicleCount = vehicleCount;
+	this->paddedCount = (vehicleCount + DYNAMICS_VECTOR_WIDTH - 1) / DYNAMICS_VECTOR_WIDTH * DYNAMICS_VECTOR_WIDTH;
+
+	float ** arrays[] = {
+		&this->throttleCommand, &this->pitchCommand, &this->rollCommand, &this->yawCommand,
+		&this->pitchRate, &this->rollRate, &this->yawRate,
+		&this->pitchAngle, &this->rollAngle, &this->headingX, &this->headingY,
+		&this->positionX, &this->positionY, &this->positionZ,
+		&this->velocityX, &this->velocityY, &this->velocityZ
+	};
+
+	for(unsigned int i = 0; i < sizeof(arrays) / sizeof(arrays[0]); i++)
+		*arrays[i] = new float[this->paddedCount];
+
+	for(int i = 0; i < this->paddedCount; i++)
+		this->reset(i);
+}
+
+FlightDynamics::~FlightDynamics()
+{
+	delete[] this->throttleCommand;
+	delete[] this->pitchCommand;
+	delete[] this->rollCommand;
+	delete[] this->yawCommand;
+	delete[] this->pitchRate;
+	delete[] this->rollRate;
+	delete[] this->yawRate;
+	delete[] this->pitchAngle;
+	delete[] this->rollAngle;
+	delete[] this->headingX;
+	delete[] this->headingY;
+	delete[] this->positionX;
+	delete[] this->positionY;
+	delete[] this->positionZ;
+	delete[] this->velocityX;
+	delete[] this->velocityY;
+	delete[] this->velocityZ;
+}
+
+void FlightDynamics::reset(int vehicle)
+{
+	if(vehicle < 0 || vehicle >= this->paddedCount)
+		return;
+
+	this->throttleCommand[vehicle] = 0;
+	this->pitchCommand[vehicle] = 0;
+	this->rollCommand[vehicle] = 0;
+	this->yawCommand[vehicle] = 0;
+	this->pitchRate[vehicle] = 0;
+	this->rollRate[vehicle] = 0;
+	this->yawRate[vehicle] = 0;
+	this->pitchAngle[vehicle] = 0;
+	this->rollAngle[vehicle] = 0;
+	this->headingX[vehicle] = 1;
+	this->headingY[vehicle] = 0;
+	this->positionX[vehicle] = 0;
+	this->positionY[vehicle] = 0;
+	this->positionZ[vehicle] = 0;
+	this->velocityX[vehicle] = 0;
+	this->velocityY[vehicle] = 0;
+	this->velocityZ[vehicle] = 0;
+}
+
+void FlightDynamics::setCommand(int vehicle, const float values[6])
+{
+	if(vehicle < 0 || vehicle >= this->vehicleCount)
+		return;
+
+	this->throttleCommand[vehicle] = values[PWM_CHANNEL_THROTTLE - 1] * .01f;
+	this->pitchCommand[vehicle] = values[PWM_CHANNEL_ELEVATOR - 1] * .02f - 1;
+	this->rollCommand[vehicle] = values[PWM_CHANNEL_AILERON - 1] * .02f - 1;
+	this->yawCommand[vehicle] = values[PWM_CHANNEL_RUDDER - 1] * .02f - 1;
+}
+
+/*
+ * The step kernels take their arrays as __restrict parameters, GCC ignores restrict on local pointers and would
+ * otherwise need more run time alias checks than it allows. Each works through the arrays in blocks of
+ * DYNAMICS_VECTOR_WIDTH vehicles, the constant inner trip count lets the vectorizer use full vectors with no
+ * scalar tail even under the -O2 cost model.
+ */
+
+//First order response of body rates to stick commands
+static void stepRates(int count, float rateBlend, const float * __restrict pitchCmd, const float * __restrict rollCmd,
+	const float * __restrict yawCmd, float * __restrict q, float * __restrict p, float * __restrict r)
+{
+	for(int block = 0; block < count; block += DYNAMICS_VECTOR_WIDTH)
+	{
+		for(int i = block; i < block + DYNAMICS_VECTOR_WIDTH; i++)
+		{
+			q[i] += (pitchCmd[i] * DYNAMICS_MAX_TILT_RATE - q[i]) * rateBlend;
+			p[i] += (rollCmd[i] * DYNAMICS_MAX_TILT_RATE - p[i]) * rateBlend;
+			r[i] += (yawCmd[i] * DYNAMICS_MAX_YAW_RATE - r[i]) * rateBlend;
+		}
+	}
+}
+
+//Integrate attitude, limiting tilt, and rotate the heading vector keeping it normalized
+static void stepAttitude(int count, float dt, const float * __restrict q, const float * __restrict p,
+	const float * __restrict r, float * __restrict pitch, float * __restrict roll, float * __restrict hx, float * __restrict hy)
+{
+	for(int block = 0; block < count; block += DYNAMICS_VECTOR_WIDTH)
+	{
+		for(int i = block; i < block + DYNAMICS_VECTOR_WIDTH; i++)
+		{
+			float newPitch = pitch[i] + q[i] * dt;
+			float newRoll = roll[i] + p[i] * dt;
+			newPitch = newPitch < DYNAMICS_MAX_TILT ? newPitch : DYNAMICS_MAX_TILT;
+			newRoll = newRoll < DYNAMICS_MAX_TILT ? newRoll : DYNAMICS_MAX_TILT;
+			pitch[i] = newPitch > -DYNAMICS_MAX_TILT ? newPitch : -DYNAMICS_MAX_TILT;
+			roll[i] = newRoll > -DYNAMICS_MAX_TILT ? newRoll : -DYNAMICS_MAX_TILT;
+
+			float turn = r[i] * dt;
+			float newX = hx[i] - turn * hy[i];
+			float newY = hy[i] + turn * hx[i];
+			float scale = 1.5f - .5f * (newX * newX + newY * newY);
+			hx[i] = newX * scale;
+			hy[i] = newY * scale;
+		}
+	}
+}
+
+//Thrust along the tilted body axis, gravity, linear drag, and ground contact where a vehicle cannot sink or slide
+static void stepMotion(int count, float dt, float dragScale, const float * __restrict throttle, const float * __restrict pitch,
+	const float * __restrict roll, const float * __restrict hx, const float * __restrict hy, float * __restrict x,
+	float * __restrict y, float * __restrict z, float * __restrict vx, float * __restrict vy, float * __restrict vz)
+{
+	for(int block = 0; block < count; block += DYNAMICS_VECTOR_WIDTH)
+	{
+		for(int i = block; i < block + DYNAMICS_VECTOR_WIDTH; i++)
+		{
+			float thrust = throttle[i] * DYNAMICS_MAX_THRUST_ACCEL;
+			float forward = thrust * pitch[i];
+			float right = thrust * roll[i];
+
+			float ax = forward * hx[i] - right * hy[i];
+			float ay = forward * hy[i] + right * hx[i];
+			float az = thrust * (1 - .5f * (pitch[i] * pitch[i] + roll[i] * roll[i])) - DYNAMICS_GRAVITY;
+
+			float newVx = (vx[i] + ax * dt) * dragScale;
+			float newVy = (vy[i] + ay * dt) * dragScale;
+			float newVz = (vz[i] + az * dt) * dragScale;
+			float newZ = z[i] + newVz * dt;
+
+			//Selects rather than branches, on the ground only a climb is kept
+			uint8_t airborne = newZ > 0;
+			float climb = newVz > 0 ? newVz : 0.f;
+
+			x[i] += newVx * dt;
+			y[i] += newVy * dt;
+			z[i] = airborne ? newZ : 0.f;
+			vx[i] = airborne ? newVx : 0.f;
+			vy[i] = airborne ? newVy : 0.f;
+			vz[i] = airborne ? newVz : climb;
+		}
+	}
+}
+
+void FlightDynamics::step(float dt)
+{
+	const float rateBlend = dt / (DYNAMICS_RATE_TIME_CONSTANT + dt);
+	const float dragScale = 1 - DYNAMICS_DRAG * dt;
+
+	stepRates(this->paddedCount, rateBlend, this->pitchCommand, this->rollCommand, this->yawCommand,
+		this->pitchRate, this->rollRate, this->yawRate);
+
+	stepAttitude(this->paddedCount, dt, this->pitchRate, this->rollRate, this->yawRate,
+		this->pitchAngle, this->rollAngle, this->headingX, this->headingY);
+
+	stepMotion(this->paddedCount, dt, dragScale, this->throttleCommand, this->pitchAngle, this->rollAngle,
+		this->headingX, this->headingY, this->positionX, this->positionY, this->positionZ,
+		this->velocityX, this->velocityY, this->velocityZ);
+}
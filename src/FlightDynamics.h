@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef FLIGHTDYNAMICS_H
+#define FLIGHTDYNAMICS_H
+
+#include "FlightChannels.h"
+#include "FlightFrame.h"
+
+//Model constants for a small quadcopter, SI units
+#define DYNAMICS_GRAVITY 9.80665f
+#define DYNAMICS_MAX_THRUST_ACCEL 19.6133f
+#define DYNAMICS_DRAG 0.35f
+#define DYNAMICS_MAX_TILT_RATE 3.5f
+#define DYNAMICS_MAX_YAW_RATE 3.0f
+#define DYNAMICS_RATE_TIME_CONSTANT 0.08f
+#define DYNAMICS_MAX_TILT 0.6f
+
+//Vehicle counts are rounded up to a multiple of this, the step kernels work through blocks of this many vehicles so
+//the vectorizer sees a constant trip count and never needs a scalar tail
+#define DYNAMICS_VECTOR_WIDTH 8
+
+/**
+ * @brief Batched quadcopter model for closed loop testing against emulated channel outputs
+ * 
+ * All state is stored as one array per quantity so a step over every vehicle is three branch free kernels over
+ * restrict qualified arrays, which GCC vectorizes at -O2 (check with -fopt-info-vec). Attitude uses a small angle approximation and heading is kept as a unit vector
+ * so no trigonometry is needed in the step.
+ */
+class FlightDynamics
+{
+protected:
+	//Number of vehicles requested and number allocated
+	int vehicleCount;
+	int paddedCount;
+
+	//Commands, throttle 0 to 1 and the rest -1 to 1
+	float * throttleCommand;
+	float * pitchCommand;
+	float * rollCommand;
+	float * yawCommand;
+
+	//Body rates in rad/s
+	float * pitchRate;
+	float * rollRate;
+	float * yawRate;
+
+	//Attitude in rad and heading as a unit vector
+	float * pitchAngle;
+	float * rollAngle;
+	float * headingX;
+	float * headingY;
+
+	//World position in m, z up
+	float * positionX;
+	float * positionY;
+	float * positionZ;
+
+	//World velocity in m/s
+	float * velocityX;
+	float * velocityY;
+	float * velocityZ;
+
+public:
+	/**
+	 * @brief Allocate state for a number of vehicles, all starting at rest on the ground at the origin
+	 * 
+	 * @param vehicleCount The number of vehicles to simulate
+	 */
+	FlightDynamics(int vehicleCount);
+
+	~FlightDynamics();
+
+	//The state arrays are owned, so a model cannot be copied
+	FlightDynamics(const FlightDynamics &) = delete;
+	FlightDynamics & operator=(const FlightDynamics &) = delete;
+
+	/**
+	 * @brief Get the number of vehicles being simulated
+	 */
+	int getVehicleCount() { return this->vehicleCount; }
+
+	/**
+	 * @brief Return a vehicle to rest on the ground at the origin
+	 * 
+	 * @param vehicle The vehicle index
+	 */
+	void reset(int vehicle);
+
+	/**
+	 * @brief Set the commands of a vehicle from emulator channel percentages
+	 * 
+	 * @param vehicle The vehicle index
+	 * @param values The output percentages of all six channels, in channel order
+	 */
+	void setCommand(int vehicle, const float values[6]);
+
+	/**
+	 * @brief Advance every vehicle by one time step
+	 * 
+	 * @param dt The step length in seconds
+	 */
+	void step(float dt);
+
+	float getX(int vehicle) { return this->positionX[vehicle]; }
+	float getY(int vehicle) { return this->positionY[vehicle]; }
+	float getAltitude(int vehicle) { return this->positionZ[vehicle]; }
+	float getVelocityX(int vehicle) { return this->velocityX[vehicle]; }
+	float getVelocityY(int vehicle) { return this->velocityY[vehicle]; }
+	float getClimbRate(int vehicle) { return this->velocityZ[vehicle]; }
+	float getPitch(int vehicle) { return this->pitchAngle[vehicle]; }
+	float getRoll(int vehicle) { return this->rollAngle[vehicle]; }
+	float getHeadingX(int vehicle) { return this->headingX[vehicle]; }
+	float getHeadingY(int vehicle) { return this->headingY[vehicle]; }
+};
+
+
+/**
+ * @brief Feeds every frame committed by an emulator into one vehicle of a FlightDynamics model
+ */
+class FlightDynamicsInput : public FlightFrameListener
+{
+protected:
+	FlightDynamics * dynamics;
+	int vehicle;
+
+public:
+	FlightDynamicsInput(FlightDynamics * dynamics, int vehicle) : dynamics(dynamics), vehicle(vehicle) {}
+
+	void onFrameCommit(const FlightFrame & frame) { this->dynamics->setCommand(this->vehicle, frame.values); }
+};
+
+#endif
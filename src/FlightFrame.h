@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef FLIGHTFRAME_H
+#define FLIGHTFRAME_H
+
+#include <stdint.h>
+
+/**
+ * @brief A committed set of outputs for all channels
+ */
+typedef struct
+{
+	//Increments by one with every commit
+	uint32_t sequence;
+
+	//Clock time of the commit in microseconds
+	uint64_t timestamp;
+
+	//The output percentages for all channels, after any receiver mix
+	float values[6];
+
+	//The protocol duty cycle percentages for all channels
+	float dutys[6];
+} FlightFrame;
+
+/**
+ * @brief Receives every frame committed by a FlightControlEmulator
+ */
+class FlightFrameListener
+{
+public:
+	virtual ~FlightFrameListener() {}
+
+	/**
+	 * @brief Called from the control path after the outputs have been changed, must not block
+	 * 
+	 * @param frame The newly committed frame
+	 */
+	virtual void onFrameCommit(const FlightFrame & frame) = 0;
+};
+
+#endif
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include "FlightSnapshot.h"
+
+#ifdef ESP_PLATFORM
+#include <esp_attr.h>
+
+//Survives every reset except loss of power
+RTC_NOINIT_ATTR static FlightSnapshot rtcSnapshot;
+#endif
+
+static uint32_t snapshotChecksum(const FlightSnapshot * snapshot)
+{
+	const uint8_t * bytes = (const uint8_t *) snapshot;
+	uint32_t crc = 0xFFFFFFFF;
+
+	for(size_t i = 0; i < offsetof(FlightSnapshot, checksum); i++)
+	{
+		crc ^= bytes[i];
+		for(int bit = 0; bit < 8; bit++)
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+	}
+
+	return ~crc;
+}
+
+void flightSnapshotSeal(FlightSnapshot * snapshot)
+{
+	snapshot->magic = FLIGHT_SNAPSHOT_MAGIC;
+	snapshot->version = FLIGHT_SNAPSHOT_VERSION;
+	snapshot->size = sizeof(FlightSnapshot);
+	snapshot->reserved = 0;
+	snapshot->checksum = snapshotChecksum(snapshot);
+}
+
+uint8_t flightSnapshotValid(const FlightSnapshot * snapshot)
+{
+	return snapshot->magic == FLIGHT_SNAPSHOT_MAGIC && snapshot->version == FLIGHT_SNAPSHOT_VERSION &&
+		snapshot->size == sizeof(FlightSnapshot) && snapshot->checksum == snapshotChecksum(snapshot);
+}
+
+#ifdef ESP_PLATFORM
+void RtcSnapshotStore::save(const FlightSnapshot & snapshot)
+{
+	rtcSnapshot = snapshot;
+}
+
+uint8_t RtcSnapshotStore::load(FlightSnapshot & snapshot)
+{
+	snapshot = rtcSnapshot;
+	return flightSnapshotValid(&snapshot);
+}
+
+void RtcSnapshotStore::clear()
+{
+	rtcSnapshot.magic = 0;
+}
+#else
+void RtcSnapshotStore::save(const FlightSnapshot & snapshot)
+{
+	(void) snapshot;
+}
+
+uint8_t RtcSnapshotStore::load(FlightSnapshot & snapshot)
+{
+	(void) snapshot;
+	return 0;
+}
+
+void RtcSnapshotStore::clear()
+{
+}
+#endif
+
+void FileSnapshotStore::write(const FlightSnapshot & snapshot)
+{
+	this->dirty = 0;
+	this->written = 1;
+	this->writtenTime = snapshot.timestamp;
+	this->writtenRunning = snapshot.running;
+
+	FILE * file = fopen(this->path, "wb");
+	if(file == NULL)
+		return;
+
+	fwrite(&snapshot, sizeof(FlightSnapshot), 1, file);
+	fclose(file);
+}
+
+void FileSnapshotStore::save(const FlightSnapshot & snapshot)
+{
+	//A start or stop always reaches the file, and so does a clock that went backwards
+	if(!this->written || snapshot.running != this->writtenRunning || snapshot.timestamp < this->writtenTime ||
+		snapshot.timestamp - this->writtenTime >= this->intervalMicros)
+	{
+		this->write(snapshot);
+		return;
+	}
+
+	this->pending = snapshot;
+	this->dirty = 1;
+}
+
+void FileSnapshotStore::flush()
+{
+	if(this->dirty)
+		this->write(this->pending);
+}
+
+uint8_t FileSnapshotStore::load(FlightSnapshot & snapshot)
+{
+	if(this->dirty)
+	{
+		snapshot = this->pending;
+		return flightSnapshotValid(&snapshot);
+	}
+
+	FILE * file = fopen(this->path, "rb");
+	if(file == NULL)
+		return 0;
+
+	size_t count = fread(&snapshot, sizeof(FlightSnapshot), 1, file);
+	fclose(file);
+
+	return count == 1 && flightSnapshotValid(&snapshot);
+}
+
+void FileSnapshotStore::clear()
+{
+	this->dirty = 0;
+	this->written = 0;
+	remove(this->path);
+}
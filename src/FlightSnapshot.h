@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef FLIGHTSNAPSHOT_H
+#define FLIGHTSNAPSHOT_H
+
+#include <stdint.h>
+
+#define FLIGHT_SNAPSHOT_MAGIC 0x46435353
+#define FLIGHT_SNAPSHOT_VERSION 2
+
+//Shortest time between writes of FileSnapshotStore, in microseconds
+#define FILE_SNAPSHOT_DEFAULT_INTERVAL_US 100000
+
+/**
+ * @brief Controller state kept across resets so outputs can resume at the last commanded values
+ */
+typedef struct
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t size;
+
+	//The FlightProtocol in use
+	uint8_t protocol;
+
+	//1 if the outputs were started when the snapshot was taken
+	uint8_t running;
+
+	uint16_t reserved;
+
+	//Sequence number of the last committed frame
+	uint32_t sequence;
+
+	//Clock time of the last committed frame in microseconds
+	uint64_t timestamp;
+
+	//The output percentages for all channels
+	float values[6];
+
+	//The protocol duty cycle percentages for all channels, only valid for the channel modes and rates in use
+	//when the snapshot was taken, a resume reapplies the values instead
+	float dutys[6];
+
+	//CRC-32 of every preceding byte
+	uint32_t checksum;
+} FlightSnapshot;
+
+/**
+ * @brief Fill in the header and checksum of a snapshot so it can be stored
+ * 
+ * @param snapshot The snapshot to seal
+ */
+void flightSnapshotSeal(FlightSnapshot * snapshot);
+
+/**
+ * @brief Check that a snapshot has the current layout and an intact checksum
+ * 
+ * @param snapshot The snapshot to check
+ * 
+ * @return
+ *     - 1 the snapshot can be used
+ *     - 0 the snapshot is missing, from another version, or corrupt
+ */
+uint8_t flightSnapshotValid(const FlightSnapshot * snapshot);
+
+
+/**
+ * @brief Somewhere to keep the snapshot across a reset
+ */
+class FlightSnapshotStore
+{
+public:
+	virtual ~FlightSnapshotStore() {}
+
+	/**
+	 * @brief Store a sealed snapshot, called on the control path after every committed frame
+	 * 
+	 * @param snapshot The snapshot to store
+	 */
+	virtual void save(const FlightSnapshot & snapshot) = 0;
+
+	/**
+	 * @brief Retrieve the stored snapshot
+	 * 
+	 * @param snapshot Where to copy the snapshot
+	 * 
+	 * @return
+	 *     - 1 a valid snapshot was found
+	 *     - 0 there is no valid snapshot
+	 */
+	virtual uint8_t load(FlightSnapshot & snapshot) = 0;
+
+	/**
+	 * @brief Invalidate the stored snapshot
+	 */
+	virtual void clear() = 0;
+
+	/**
+	 * @brief Write out a snapshot the store has held back, called when the outputs are stopped
+	 */
+	virtual void flush() {}
+};
+
+
+/**
+ * @brief Keeps the snapshot in RTC memory that is not cleared by software, watchdog or brownout resets
+ * @note Only available on the ESP32, contents are lost on a full power cycle
+ */
+class RtcSnapshotStore : public FlightSnapshotStore
+{
+public:
+	void save(const FlightSnapshot & snapshot);
+	uint8_t load(FlightSnapshot & snapshot);
+	void clear();
+};
+
+
+/**
+ * @brief Keeps the snapshot in a file, for host builds
+ * 
+ * The file is rewritten at most once per interval of snapshot time, and whenever the outputs start or stop. Snapshots
+ * saved in between are held in memory until the next write or flush.
+ */
+class FileSnapshotStore : public FlightSnapshotStore
+{
+protected:
+	//Path of the snapshot file
+	const char * path;
+
+	//Shortest snapshot time between file writes in microseconds
+	uint64_t intervalMicros;
+
+	//The newest snapshot, and whether it is newer than the file
+	FlightSnapshot pending;
+	uint8_t dirty;
+
+	//Whether the file holds a snapshot from this store, and the time and running state of that snapshot
+	uint8_t written;
+	uint64_t writtenTime;
+	uint8_t writtenRunning;
+
+	/**
+	 * @brief Replace the file contents with a snapshot
+	 * 
+	 * @param snapshot The snapshot to write
+	 */
+	void write(const FlightSnapshot & snapshot);
+
+public:
+	/**
+	 * @brief Use the given file to hold the snapshot
+	 * 
+	 * @param path The file path
+	 * @param intervalMicros The shortest snapshot time between file writes
+	 */
+	FileSnapshotStore(const char * path, uint64_t intervalMicros = FILE_SNAPSHOT_DEFAULT_INTERVAL_US) : path(path),
+		intervalMicros(intervalMicros), dirty(0), written(0), writtenTime(0), writtenRunning(0) {}
+
+	~FileSnapshotStore() { this->flush(); }
+
+	void save(const FlightSnapshot & snapshot);
+	uint8_t load(FlightSnapshot & snapshot);
+	void clear();
+	void flush();
+};
+
+#endif
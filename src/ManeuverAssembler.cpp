@@ -0,0 +1,231 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "ManeuverAssembler.h"
+#include "ManeuverBytecode.h"
+#include "FlightChannels.h"
+
+static const char * channelNames[] = { "aileron", "throttle", "elevator", "rudder", "aux1", "aux2" };
+static const uint8_t channelNumbers[] = { PWM_CHANNEL_AILERON, PWM_CHANNEL_THROTTLE, PWM_CHANNEL_ELEVATOR, PWM_CHANNEL_RUDDER, PWM_CHANNEL_AUX_A, PWM_CHANNEL_AUX_B };
+
+//Parse a whole token as a number, returning 0 if it is not one
+static uint8_t parseNumber(const char * token, float minimum, float maximum, float * value)
+{
+	char * end;
+	*value = strtod(token, &end);
+
+	return end != token && *end == '\0' && *value >= minimum && *value <= maximum;
+}
+
+//Parse a whole number in a range, frame counts are never rounded
+static uint8_t parseCount(const char * token, float minimum, float maximum, float * value)
+{
+	return parseNumber(token, minimum, maximum, value) && *value == (int) *value;
+}
+
+//Parse a channel name or number, returning 0 if it is neither
+static uint8_t parseChannel(const char * token)
+{
+	for(int i = 0; i < 6; i++)
+	{
+		if(strcmp(token, channelNames[i]) == 0)
+			return channelNumbers[i];
+	}
+
+	float number;
+	if(parseCount(token, 1, 6, &number))
+		return (uint8_t) number;
+
+	return 0;
+}
+
+//Convert a percentage or value into the bytecode fixed point
+static uint16_t fixedPoint(float value)
+{
+	return (uint16_t) (value * 100 + .5f);
+}
+
+//Assemble one tokenized statement, returning the number of bytes written or -1
+static int assembleStatement(char ** tokens, int count, uint8_t * out)
+{
+	float value, frames;
+
+	if(strcmp(tokens[0], "end") == 0 && count == 1)
+	{
+		out[0] = MANEUVER_OP_END;
+		return 1;
+	}
+
+	if(strcmp(tokens[0], "next") == 0 && count == 1)
+	{
+		out[0] = MANEUVER_OP_NEXT;
+		return 1;
+	}
+
+	if(strcmp(tokens[0], "set") == 0 && count == 3)
+	{
+		uint8_t channel = parseChannel(tokens[1]);
+		if(channel == 0 || !parseNumber(tokens[2], 0, 100, &value))
+			return -1;
+
+		out[0] = MANEUVER_OP_SET;
+		out[1] = channel;
+		out[2] = fixedPoint(value) & 0xFF;
+		out[3] = fixedPoint(value) >> 8;
+		return 4;
+	}
+
+	if(strcmp(tokens[0], "ramp") == 0 && count == 4)
+	{
+		uint8_t channel = parseChannel(tokens[1]);
+		if(channel == 0 || !parseNumber(tokens[2], 0, 100, &value) || !parseCount(tokens[3], 1, 65535, &frames))
+			return -1;
+
+		out[0] = MANEUVER_OP_RAMP;
+		out[1] = channel;
+		out[2] = fixedPoint(value) & 0xFF;
+		out[3] = fixedPoint(value) >> 8;
+		out[4] = (uint16_t) frames & 0xFF;
+		out[5] = (uint16_t) frames >> 8;
+		return 6;
+	}
+
+	if((strcmp(tokens[0], "wait") == 0 || strcmp(tokens[0], "loop") == 0) && count == 2)
+	{
+		if(!parseCount(tokens[1], tokens[0][0] == 'w' ? 0 : 1, 65535, &frames))
+			return -1;
+
+		out[0] = tokens[0][0] == 'w' ? MANEUVER_OP_WAIT : MANEUVER_OP_LOOP;
+		out[1] = (uint16_t) frames & 0xFF;
+		out[2] = (uint16_t) frames >> 8;
+		return 3;
+	}
+
+	if(strcmp(tokens[0], "abort_if") == 0 && count == 4)
+	{
+		uint8_t source = parseChannel(tokens[1]);
+		if(source == 0 && strncmp(tokens[1], "in", 2) == 0 && parseCount(tokens[1] + 2, 0, MANEUVER_INPUT_COUNT - 1, &value))
+			source = MANEUVER_SOURCE_INPUT + (uint8_t) value;
+
+		uint8_t comparison;
+		if(strcmp(tokens[2], "below") == 0)
+			comparison = MANEUVER_COMPARE_BELOW;
+		else if(strcmp(tokens[2], "above") == 0)
+			comparison = MANEUVER_COMPARE_ABOVE;
+		else
+			return -1;
+
+		if(source == 0 || !parseNumber(tokens[3], 0, 655.35f, &value))
+			return -1;
+
+		out[0] = MANEUVER_OP_ABORT_IF;
+		out[1] = source;
+		out[2] = comparison;
+		out[3] = fixedPoint(value) & 0xFF;
+		out[4] = fixedPoint(value) >> 8;
+		return 5;
+	}
+
+	return -1;
+}
+
+int maneuverAssemble(const char * source, uint8_t * code, uint16_t capacity, uint16_t * errorStatement)
+{
+	uint16_t length = 0;
+	uint16_t statement = 0;
+
+	while(*source != '\0')
+	{
+		//Copy out the next statement, dropping any comment
+		char text[MANEUVER_STATEMENT_LENGTH + 1];
+		int textLength = 0;
+		uint8_t inComment = 0;
+
+		for(; *source != '\0' && *source != '\n' && *source != ';'; source++)
+		{
+			if(*source == '#')
+				inComment = 1;
+
+			if(inComment)
+				continue;
+
+			if(textLength == MANEUVER_STATEMENT_LENGTH)
+			{
+				if(errorStatement != NULL)
+					*errorStatement = statement + 1;
+				return -1;
+			}
+
+			text[textLength++] = *source;
+		}
+
+		text[textLength] = '\0';
+		if(*source != '\0')
+			source++;
+
+		statement++;
+
+		//Split on whitespace in place
+		char * tokens[5];
+		int count = 0;
+		char * cursor = text;
+
+		while(*cursor != '\0')
+		{
+			while(*cursor == ' ' || *cursor == '\t' || *cursor == '\r')
+				*cursor++ = '\0';
+
+			if(*cursor == '\0')
+				break;
+
+			if(count == 5)
+			{
+				count = -1;
+				break;
+			}
+
+			tokens[count++] = cursor;
+			while(*cursor != '\0' && *cursor != ' ' && *cursor != '\t' && *cursor != '\r')
+				cursor++;
+		}
+
+		if(count == 0)
+			continue;
+
+		uint8_t instruction[6];
+		int size = count < 0 ? -1 : assembleStatement(tokens, count, instruction);
+
+		if(size < 0 || length + size > capacity)
+		{
+			if(errorStatement != NULL)
+				*errorStatement = statement;
+			return -1;
+		}
+
+		for(int i = 0; i < size; i++)
+			code[length++] = instruction[i];
+	}
+
+	return length;
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MANEUVERASSEMBLER_H
+#define MANEUVERASSEMBLER_H
+
+#include <stdint.h>
+
+/*
+ * Manoeuvre source text, one statement per line or separated by ';', '#' starts a comment.
+ *
+ *     set <channel> <percent>
+ *     ramp <channel> <percent> <frames>
+ *     wait <frames>
+ *     loop <count>
+ *     next
+ *     abort_if <channel | in0-in7> below|above <value>
+ *     end
+ *
+ * A channel is aileron, throttle, elevator, rudder, aux1, aux2 or its number 1-6. Percentages and values
+ * keep two decimal places, frame and loop counts must be whole numbers. See ManeuverBytecode.h for the bytecode each statement becomes.
+ */
+
+//Longest statement accepted, in characters
+#define MANEUVER_STATEMENT_LENGTH 64
+
+/**
+ * @brief Assemble manoeuvre source text into bytecode for ManeuverRunner::load
+ * 
+ * @param source The null terminated source text
+ * @param code Where to write the bytecode
+ * @param capacity The size of the code buffer
+ * @param errorStatement Set to the 1 based number of the statement that failed, may be null
+ * 
+ * @return The number of bytecode bytes written, or -1 if a statement is invalid or the code buffer is full
+ */
+int maneuverAssemble(const char * source, uint8_t * code, uint16_t capacity, uint16_t * errorStatement);
+
+#endif
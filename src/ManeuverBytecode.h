@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MANEUVERBYTECODE_H
+#define MANEUVERBYTECODE_H
+
+/*
+ * Manoeuvre bytecode, one opcode byte followed by its operands, 16 bit operands are little endian.
+ * Channels are 1-6 as in PWM_CHANNEL_*, output values are in hundredths of a percent (0-10000).
+ *
+ *     END                                       stop, the program is done once every running ramp has finished
+ *     SET      channel value                    set a channel output
+ *     RAMP     channel target(16) frames(16)    move a channel linearly to target over a number of frames,
+ *                                               runs alongside the rest of the program
+ *     WAIT     frames(16)                       let a number of frames pass
+ *     LOOP     count(16)                        repeat the instructions up to the matching NEXT count times
+ *     NEXT                                      end of a loop body
+ *     ABORT_IF source comparison threshold(16)  from now on, abort and idle if source is below (0) or above (1)
+ *                                               the threshold, checked at the start of every frame
+ *
+ * A source is a channel 1-6, its committed output compared in hundredths of a percent, or MANEUVER_SOURCE_INPUT + n for input
+ * register n set by the application with ManeuverRunner::setInput, compared against threshold / 100.
+ */
+
+#define MANEUVER_OP_END 0x00
+#define MANEUVER_OP_SET 0x01
+#define MANEUVER_OP_RAMP 0x02
+#define MANEUVER_OP_WAIT 0x03
+#define MANEUVER_OP_LOOP 0x04
+#define MANEUVER_OP_NEXT 0x05
+#define MANEUVER_OP_ABORT_IF 0x06
+
+#define MANEUVER_SOURCE_INPUT 0x10
+#define MANEUVER_COMPARE_BELOW 0
+#define MANEUVER_COMPARE_ABOVE 1
+
+#define MANEUVER_PROGRAM_SIZE 256
+#define MANEUVER_INPUT_COUNT 8
+#define MANEUVER_VALUE_MAXIMUM 10000
+
+#endif
@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "ManeuverProgram.h"
+
+//Number of operand bytes following each opcode
+static const uint8_t operandLengths[] = { 0, 3, 5, 2, 2, 0, 4 };
+
+static uint16_t readWord(const uint8_t * bytes)
+{
+	return bytes[0] | (bytes[1] << 8);
+}
+
+ManeuverRunner::ManeuverRunner(FlightControlEmulator * controller)
+{
+	this->controller = controller;
+	this->programLength = 0;
+	this->state = MANEUVER_IDLE;
+
+	for(int i = 0; i < MANEUVER_INPUT_COUNT; i++)
+		this->inputs[i] = 0;
+}
+
+maneuver_state ManeuverRunner::load(const uint8_t * code, uint16_t length)
+{
+	this->programLength = 0;
+	this->state = MANEUVER_IDLE;
+
+	if(length > MANEUVER_PROGRAM_SIZE)
+		return MANEUVER_ERROR;
+
+	//Walk the program once so step never has to bounds check, or run out of guards
+	int depth = 0;
+	int guards = 0;
+	uint16_t pc = 0;
+
+	while(pc < length)
+	{
+		uint8_t op = code[pc];
+		if(op >= sizeof(operandLengths) || pc + 1 + operandLengths[op] > length)
+			return MANEUVER_ERROR;
+
+		const uint8_t * operands = &code[pc + 1];
+
+		switch(op)
+		{
+			case MANEUVER_OP_SET:
+				if(operands[0] < 1 || operands[0] > 6 || readWord(&operands[1]) > MANEUVER_VALUE_MAXIMUM)
+					return MANEUVER_ERROR;
+				break;
+			case MANEUVER_OP_RAMP:
+				if(operands[0] < 1 || operands[0] > 6 || readWord(&operands[1]) > MANEUVER_VALUE_MAXIMUM || readWord(&operands[3]) == 0)
+					return MANEUVER_ERROR;
+				break;
+			case MANEUVER_OP_LOOP:
+				if(readWord(&operands[0]) == 0 || ++depth > MANEUVER_LOOP_DEPTH)
+					return MANEUVER_ERROR;
+				break;
+			case MANEUVER_OP_NEXT:
+				if(--depth < 0)
+					return MANEUVER_ERROR;
+				break;
+			case MANEUVER_OP_ABORT_IF:
+				if(!((operands[0] >= 1 && operands[0] <= 6) || (operands[0] >= MANEUVER_SOURCE_INPUT && operands[0] < MANEUVER_SOURCE_INPUT + MANEUVER_INPUT_COUNT)))
+					return MANEUVER_ERROR;
+				if(operands[1] > MANEUVER_COMPARE_ABOVE || ++guards > MANEUVER_GUARD_COUNT)
+					return MANEUVER_ERROR;
+				break;
+			default:
+				break;
+		}
+
+		pc += 1 + operandLengths[op];
+	}
+
+	if(depth != 0)
+		return MANEUVER_ERROR;
+
+	for(uint16_t i = 0; i < length; i++)
+		this->program[i] = code[i];
+
+	this->programLength = length;
+
+	return MANEUVER_IDLE;
+}
+
+maneuver_state ManeuverRunner::start()
+{
+	FlightFrame frame;
+
+	if(this->programLength == 0 || !this->controller->getChannelState(frame))
+	{
+		this->state = MANEUVER_ERROR;
+		return this->state;
+	}
+
+	for(int i = 0; i < 6; i++)
+	{
+		this->values[i] = frame.values[i];
+		this->rampFrames[i] = 0;
+	}
+
+	this->programCounter = 0;
+	this->waitFrames = 0;
+	this->loopDepth = 0;
+	this->guardCount = 0;
+	this->state = MANEUVER_RUNNING;
+
+	return this->state;
+}
+
+void ManeuverRunner::abort()
+{
+	if(this->state == MANEUVER_RUNNING)
+		this->controller->idle();
+
+	this->state = MANEUVER_ABORTED;
+}
+
+void ManeuverRunner::fail()
+{
+	if(this->state == MANEUVER_RUNNING)
+		this->controller->idle();
+
+	this->state = MANEUVER_ERROR;
+}
+
+uint8_t ManeuverRunner::guardTriggered()
+{
+	if(this->guardCount == 0)
+		return 0;
+
+	//Channels are checked against what is actually being output, which other writers may have changed
+	FlightFrame frame;
+	if(!this->controller->getChannelState(frame))
+		return 0;
+
+	for(int i = 0; i < this->guardCount; i++)
+	{
+		float value;
+		float threshold = this->guardThreshold[i] * .01f;
+
+		if(this->guardSource[i] >= MANEUVER_SOURCE_INPUT)
+			value = this->inputs[this->guardSource[i] - MANEUVER_SOURCE_INPUT];
+		else
+			value = frame.values[this->guardSource[i] - 1];
+
+		if(this->guardComparison[i] == MANEUVER_COMPARE_ABOVE ? value > threshold : value < threshold)
+			return 1;
+	}
+
+	return 0;
+}
+
+maneuver_state ManeuverRunner::step()
+{
+	if(this->state != MANEUVER_RUNNING)
+		return this->state;
+
+	if(this->guardTriggered())
+	{
+		this->abort();
+		return this->state;
+	}
+
+	uint8_t changed = 0;
+
+	//Ramps advance one frame, the last frame lands exactly on the target
+	for(int i = 0; i < 6; i++)
+	{
+		if(this->rampFrames[i] == 0)
+			continue;
+
+		if(--this->rampFrames[i] == 0)
+			this->values[i] = this->rampTarget[i];
+		else
+			this->values[i] += this->rampStep[i];
+
+		changed |= 1 << i;
+	}
+
+	if(this->waitFrames > 0)
+		this->waitFrames--;
+
+	int executed = 0;
+
+	//A program counter past the end means the program has finished and only ramps are left running, a full
+	//instruction budget carries on from the same place next frame
+	while(this->waitFrames == 0 && this->state == MANEUVER_RUNNING && this->programCounter < this->programLength &&
+		executed++ < MANEUVER_STEP_INSTRUCTIONS)
+	{
+		const uint8_t * instruction = &this->program[this->programCounter];
+		const uint8_t * operands = instruction + 1;
+		this->programCounter += 1 + operandLengths[instruction[0]];
+
+		switch(instruction[0])
+		{
+			case MANEUVER_OP_END:
+				this->programCounter = this->programLength;
+				break;
+
+			case MANEUVER_OP_SET:
+			{
+				int channel = operands[0] - 1;
+				this->values[channel] = readWord(&operands[1]) * .01f;
+				this->rampFrames[channel] = 0;
+				changed |= 1 << channel;
+				break;
+			}
+
+			case MANEUVER_OP_RAMP:
+			{
+				int channel = operands[0] - 1;
+				this->rampTarget[channel] = readWord(&operands[1]) * .01f;
+				this->rampFrames[channel] = readWord(&operands[3]);
+				this->rampStep[channel] = (this->rampTarget[channel] - this->values[channel]) / this->rampFrames[channel];
+				changed |= 1 << channel;
+				break;
+			}
+
+			case MANEUVER_OP_WAIT:
+				this->waitFrames = readWord(&operands[0]);
+				break;
+
+			case MANEUVER_OP_LOOP:
+				this->loopStart[this->loopDepth] = this->programCounter;
+				this->loopRemaining[this->loopDepth] = readWord(&operands[0]);
+				this->loopDepth++;
+				break;
+
+			case MANEUVER_OP_NEXT:
+				if(--this->loopRemaining[this->loopDepth - 1] > 0)
+					this->programCounter = this->loopStart[this->loopDepth - 1];
+				else
+					this->loopDepth--;
+				break;
+
+			case MANEUVER_OP_ABORT_IF:
+			{
+				//A guard inside a loop body is reached again on every pass, it is already installed
+				uint16_t address = instruction - this->program;
+				uint8_t installed = 0;
+
+				for(int i = 0; i < this->guardCount; i++)
+					installed |= this->guardAddress[i] == address;
+
+				if(installed)
+					break;
+
+				//load counts the guards, so this only protects against a corrupted program
+				if(this->guardCount >= MANEUVER_GUARD_COUNT)
+				{
+					this->fail();
+					break;
+				}
+
+				this->guardAddress[this->guardCount] = address;
+				this->guardSource[this->guardCount] = operands[0];
+				this->guardComparison[this->guardCount] = operands[1];
+				this->guardThreshold[this->guardCount] = readWord(&operands[2]);
+				this->guardCount++;
+				break;
+			}
+		}
+	}
+
+	if(this->state == MANEUVER_ERROR)
+		return this->state;
+
+	if(changed && this->controller->setChannelFrame(this->values, changed) != FLIGHT_SUCCESS)
+	{
+		this->fail();
+		return this->state;
+	}
+
+	//The program is done once it has finished, its last wait has passed, and every ramp has reached its target
+	if(this->programCounter < this->programLength || this->waitFrames > 0)
+		return this->state;
+
+	for(int i = 0; i < 6; i++)
+	{
+		if(this->rampFrames[i] > 0)
+			return this->state;
+	}
+
+	this->state = MANEUVER_DONE;
+	return this->state;
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MANEUVERPROGRAM_H
+#define MANEUVERPROGRAM_H
+
+#include "FlightControlEmulator.h"
+#include "ManeuverBytecode.h"
+
+#define MANEUVER_LOOP_DEPTH 4
+#define MANEUVER_GUARD_COUNT 4
+
+//Limit on instructions run in one frame, a loop without a WAIT carries on in the next frame rather than stalling
+//the control path
+#define MANEUVER_STEP_INSTRUCTIONS 64
+
+/**
+ * @brief Manoeuvre execution states
+ */
+typedef enum
+{
+	MANEUVER_IDLE = 0,
+	MANEUVER_RUNNING,
+	MANEUVER_DONE,
+	MANEUVER_ABORTED,
+	MANEUVER_ERROR
+} maneuver_state;
+
+/**
+ * @brief Steps an uploaded manoeuvre program once per output frame, committing each frame's channel
+ * changes to the emulator as one batch, with no allocation
+ */
+class ManeuverRunner
+{
+protected:
+	//The emulator being commanded
+	FlightControlEmulator * controller;
+
+	//The uploaded program
+	uint8_t program[MANEUVER_PROGRAM_SIZE];
+	uint16_t programLength;
+
+	//Execution state
+	maneuver_state state;
+	uint16_t programCounter;
+	uint16_t waitFrames;
+
+	//Loop bodies being repeated, innermost last
+	uint16_t loopStart[MANEUVER_LOOP_DEPTH];
+	uint16_t loopRemaining[MANEUVER_LOOP_DEPTH];
+	uint8_t loopDepth;
+
+	//Active abort conditions, each installed once by the ABORT_IF at its program address even inside a loop
+	uint16_t guardAddress[MANEUVER_GUARD_COUNT];
+	uint8_t guardSource[MANEUVER_GUARD_COUNT];
+	uint8_t guardComparison[MANEUVER_GUARD_COUNT];
+	uint16_t guardThreshold[MANEUVER_GUARD_COUNT];
+	uint8_t guardCount;
+
+	//Channel ramps, a channel is ramping while its frame count is above 0
+	float rampStep[6];
+	float rampTarget[6];
+	uint16_t rampFrames[6];
+
+	//Channel outputs as commanded by the program
+	float values[6];
+
+	//Application supplied values for abort conditions
+	float inputs[MANEUVER_INPUT_COUNT];
+
+	/**
+	 * @brief Check every installed abort condition against the committed outputs and the inputs
+	 * 
+	 * @return
+	 *     - 1 a condition is met
+	 *     - 0 keep running
+	 */
+	uint8_t guardTriggered();
+
+	/**
+	 * @brief Stop the program with an error, idling the emulator as abort does
+	 */
+	void fail();
+
+public:
+	/**
+	 * @brief Prepare a runner with no program for the given emulator
+	 * 
+	 * @param controller The emulator to command
+	 */
+	ManeuverRunner(FlightControlEmulator * controller);
+
+	/**
+	 * @brief Copy a program into the runner after checking its structure, stops any running program
+	 * 
+	 * @param code The bytecode
+	 * @param length The number of bytes of bytecode
+	 * 
+	 * @return
+	 *     - MANEUVER_IDLE the program is loaded and ready to start
+	 *     - MANEUVER_ERROR the program is too long or malformed, or has more than MANEUVER_GUARD_COUNT ABORT_IF
+	 *       instructions, nothing is loaded
+	 */
+	maneuver_state load(const uint8_t * code, uint16_t length);
+
+	/**
+	 * @brief Start the loaded program from the beginning, starting from the emulator's current outputs
+	 * 
+	 * @return
+	 *     - MANEUVER_RUNNING the program has started
+	 *     - MANEUVER_ERROR no program is loaded or the emulator state could not be read
+	 */
+	maneuver_state start();
+
+	/**
+	 * @brief Run the program for one output frame, up to MANEUVER_STEP_INSTRUCTIONS instructions, and commit the
+	 * frame's channel changes as one batch
+	 * 
+	 * @return The state after the frame, MANEUVER_RUNNING until the program has finished and its ramps have ended.
+	 * On MANEUVER_ERROR the emulator has been idled
+	 */
+	maneuver_state step();
+
+	/**
+	 * @brief Stop the program and idle the emulator
+	 */
+	void abort();
+
+	/**
+	 * @brief Set an input register for abort conditions
+	 * 
+	 * @param index The register, 0 to MANEUVER_INPUT_COUNT - 1
+	 * @param value The new value
+	 */
+	void setInput(uint8_t index, float value) { if(index < MANEUVER_INPUT_COUNT) this->inputs[index] = value; }
+
+	/**
+	 * @brief Get the execution state
+	 */
+	maneuver_state getState() { return this->state; }
+};
+
+#endif
@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+#include "MavlinkIngest.h"
+#include "TraceRecorder.h"
+
+//Unused RC_CHANNELS_OVERRIDE fields, 0 releases the channel and UINT16_MAX ignores it
+#define MAVLINK_OVERRIDE_RELEASE 0
+#define MAVLINK_OVERRIDE_IGNORE 0xFFFF
+
+//MANUAL_CONTROL axes set to this are invalid
+#define MAVLINK_AXIS_INVALID 0x7FFF
+
+static uint16_t readWord(const uint8_t * bytes)
+{
+	return bytes[0] | (bytes[1] << 8);
+}
+
+static float clampPercentage(float value)
+{
+	return value < 0 ? 0 : (value > 100 ? 100 : value);
+}
+
+MavlinkIngest::MavlinkIngest(FlightControlEmulator * controller, uint8_t systemId)
+{
+	this->controller = controller;
+	this->systemId = systemId;
+	this->commands = 0;
+	this->rejected = 0;
+	this->truncatedDatagrams = 0;
+}
+
+uint8_t MavlinkIngest::parse(uint8_t byte)
+{
+	//Mark the arrival of each frame rather than every byte
+	if(!this->parser.receiving() && (byte == MAVLINK_STX_V1 || byte == MAVLINK_STX_V2))
+		FCE_TRACE_INSTANT(TRACE_BYTE_RX, byte, 0);
+
+	if(!this->parser.parse(byte))
+		return 0;
+
+	return this->handleMessage();
+}
+
+uint16_t MavlinkIngest::parse(const uint8_t * bytes, uint16_t length)
+{
+	uint16_t commands = 0;
+
+	//A frame cut short by the end of the last datagram would otherwise swallow the start of this one
+	this->parser.dropPartialFrame();
+
+	for(uint16_t i = 0; i < length; i++)
+		commands += this->parse(bytes[i]);
+
+	return commands;
+}
+
+mavlink_ingest_stats_t MavlinkIngest::getStats()
+{
+	mavlink_parser_stats_t parserStats = this->parser.getStats();
+
+	mavlink_ingest_stats_t stats;
+	stats.frames = parserStats.frames;
+	stats.checksumErrors = parserStats.checksumErrors;
+	stats.droppedBytes = parserStats.droppedBytes;
+	stats.unknownMessages = parserStats.unknownMessages;
+	stats.incompatibleFrames = parserStats.incompatibleFrames;
+	stats.commands = this->commands;
+	stats.rejected = this->rejected;
+	stats.truncatedDatagrams = this->truncatedDatagrams;
+
+	return stats;
+}
+
+uint8_t MavlinkIngest::handleMessage()
+{
+	const mavlink_parsed_message_t & message = this->parser.getMessage();
+
+	FCE_TRACE_SCOPE(TRACE_COMMAND_PARSE, message.id);
+
+	if(message.id == MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE)
+		return this->handleOverride(message.payload);
+
+	if(message.id == MAVLINK_MSG_ID_MANUAL_CONTROL)
+		return this->handleManualControl(message.payload);
+
+	return 0;
+}
+
+uint8_t MavlinkIngest::handleOverride(const uint8_t * payload)
+{
+	uint8_t targetSystem = payload[16];
+
+	if(this->systemId != 0 && targetSystem != this->systemId)
+	{
+		this->rejected++;
+		return 0;
+	}
+
+	float values[6];
+	uint8_t channelMask = 0;
+
+	//chan1_raw to chan6_raw map straight onto the emulator channels
+	for(int i = 0; i < 6; i++)
+	{
+		uint16_t raw = readWord(&payload[i * 2]);
+		if(raw == MAVLINK_OVERRIDE_RELEASE || raw == MAVLINK_OVERRIDE_IGNORE)
+			continue;
+
+		values[i] = clampPercentage((raw - 1000) * .1f);
+		channelMask |= 1 << i;
+	}
+
+	return this->commit(values, channelMask);
+}
+
+uint8_t MavlinkIngest::handleManualControl(const uint8_t * payload)
+{
+	uint8_t targetSystem = payload[10];
+
+	if(this->systemId != 0 && targetSystem != this->systemId)
+	{
+		this->rejected++;
+		return 0;
+	}
+
+	int16_t x = (int16_t) readWord(&payload[0]);
+	int16_t y = (int16_t) readWord(&payload[2]);
+	int16_t z = (int16_t) readWord(&payload[4]);
+	int16_t r = (int16_t) readWord(&payload[6]);
+
+	float values[6];
+	uint8_t channelMask = 0;
+
+	//Stick axes are -1000 to 1000, thrust is 0 to 1000
+	if(x != MAVLINK_AXIS_INVALID)
+	{
+		values[PWM_CHANNEL_ELEVATOR - 1] = clampPercentage((x + 1000) * .05f);
+		channelMask |= 1 << (PWM_CHANNEL_ELEVATOR - 1);
+	}
+
+	if(y != MAVLINK_AXIS_INVALID)
+	{
+		values[PWM_CHANNEL_AILERON - 1] = clampPercentage((y + 1000) * .05f);
+		channelMask |= 1 << (PWM_CHANNEL_AILERON - 1);
+	}
+
+	if(z != MAVLINK_AXIS_INVALID)
+	{
+		values[PWM_CHANNEL_THROTTLE - 1] = clampPercentage(z * .1f);
+		channelMask |= 1 << (PWM_CHANNEL_THROTTLE - 1);
+	}
+
+	if(r != MAVLINK_AXIS_INVALID)
+	{
+		values[PWM_CHANNEL_RUDDER - 1] = clampPercentage((r + 1000) * .05f);
+		channelMask |= 1 << (PWM_CHANNEL_RUDDER - 1);
+	}
+
+	return this->commit(values, channelMask);
+}
+
+uint8_t MavlinkIngest::commit(const float values[6], uint8_t channelMask)
+{
+	if(channelMask == 0)
+		return 0;
+
+	if(this->controller->setChannelFrame(values, channelMask) != FLIGHT_SUCCESS)
+	{
+		this->rejected++;
+		return 0;
+	}
+
+	this->commands++;
+	return 1;
+}
+
+#if defined(__linux__) && !defined(ESP_PLATFORM)
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+uint8_t MavlinkUdpReceiver::open(uint16_t port)
+{
+	this->close();
+
+	this->socketHandle = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+	if(this->socketHandle < 0)
+		return 0;
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_port = htons(port);
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	if(bind(this->socketHandle, (sockaddr *) &address, sizeof(address)) != 0)
+	{
+		this->close();
+		return 0;
+	}
+
+	return 1;
+}
+
+void MavlinkUdpReceiver::close()
+{
+	if(this->socketHandle >= 0)
+		::close(this->socketHandle);
+
+	this->socketHandle = -1;
+}
+
+int MavlinkUdpReceiver::receive(int timeoutMillis)
+{
+	if(this->socketHandle < 0)
+		return 0;
+
+	if(timeoutMillis > 0)
+	{
+		pollfd request = { this->socketHandle, POLLIN, 0 };
+		if(poll(&request, 1, timeoutMillis) <= 0)
+			return 0;
+	}
+
+	mmsghdr messages[MAVLINK_UDP_BATCH];
+	iovec vectors[MAVLINK_UDP_BATCH];
+
+	for(int i = 0; i < MAVLINK_UDP_BATCH; i++)
+	{
+		vectors[i].iov_base = this->buffers[i];
+		vectors[i].iov_len = sizeof(this->buffers[i]);
+		memset(&messages[i].msg_hdr, 0, sizeof(messages[i].msg_hdr));
+		messages[i].msg_hdr.msg_iov = &vectors[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	int total = 0;
+	int count;
+
+	//Keep draining while full batches come back
+	do
+	{
+		count = recvmmsg(this->socketHandle, messages, MAVLINK_UDP_BATCH, MSG_DONTWAIT, NULL);
+		if(count <= 0)
+			break;
+
+		for(int i = 0; i < count; i++)
+		{
+			//The tail of a cut datagram is gone, whatever frame it ended in cannot be trusted
+			if(messages[i].msg_hdr.msg_flags & MSG_TRUNC)
+				this->ingest->countTruncated();
+			else
+				this->ingest->parse(this->buffers[i], messages[i].msg_len);
+		}
+
+		total += count;
+	} while(count == MAVLINK_UDP_BATCH);
+
+	return total;
+}
+
+#else
+
+uint8_t MavlinkUdpReceiver::open(uint16_t port)
+{
+	(void) port;
+	return 0;
+}
+
+void MavlinkUdpReceiver::close()
+{
+}
+
+int MavlinkUdpReceiver::receive(int timeoutMillis)
+{
+	(void) timeoutMillis;
+	return 0;
+}
+
+#endif
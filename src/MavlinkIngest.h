@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MAVLINKINGEST_H
+#define MAVLINKINGEST_H
+
+#include "FlightControlEmulator.h"
+#include "MavlinkParser.h"
+
+//Number of datagrams read per system call by MavlinkUdpReceiver
+#define MAVLINK_UDP_BATCH 32
+#define MAVLINK_UDP_DEFAULT_PORT 14550
+
+/**
+ * @brief Counters kept by the MAVLink ingest
+ */
+typedef struct
+{
+	//Frames with a valid checksum, of a message in the parser CRC_EXTRA table
+	uint32_t frames;
+
+	//Frames of a message in the CRC_EXTRA table dropped for a bad checksum
+	uint32_t checksumErrors;
+
+	//Bytes skipped while looking for the start of a frame, or left in a frame a datagram cut short
+	uint32_t droppedBytes;
+
+	//Complete frames of messages missing from the CRC_EXTRA table
+	uint32_t unknownMessages;
+
+	//v2 frames dropped for unknown incompat_flags bits
+	uint32_t incompatibleFrames;
+
+	//RC_CHANNELS_OVERRIDE and MANUAL_CONTROL messages committed to the emulator
+	uint32_t commands;
+
+	//Supported messages addressed to another system, or that the emulator rejected
+	uint32_t rejected;
+
+	//Datagrams longer than a receive buffer, dropped without being parsed
+	uint32_t truncatedDatagrams;
+} mavlink_ingest_stats_t;
+
+/**
+ * @brief Feeds a MAVLink v1/v2 byte stream to a MavlinkParser and turns each RC_CHANNELS_OVERRIDE and
+ * MANUAL_CONTROL message into one batched channel frame commit on the emulator
+ */
+class MavlinkIngest
+{
+protected:
+	//The emulator being commanded
+	FlightControlEmulator * controller;
+
+	//The system id messages must target, 0 to accept any
+	uint8_t systemId;
+
+	//Frames and checks the stream
+	MavlinkParser parser;
+
+	//Commands committed and rejected and datagrams dropped, the frame counters are kept by the parser
+	uint32_t commands;
+	uint32_t rejected;
+	uint32_t truncatedDatagrams;
+
+	/**
+	 * @brief Dispatch the message the parser just completed
+	 * 
+	 * @return
+	 *     - 1 a command was committed
+	 *     - 0 otherwise
+	 */
+	uint8_t handleMessage();
+
+	/**
+	 * @brief Commit an RC_CHANNELS_OVERRIDE payload, zero extended to its full length
+	 */
+	uint8_t handleOverride(const uint8_t * payload);
+
+	/**
+	 * @brief Commit a MANUAL_CONTROL payload, zero extended to its full length
+	 */
+	uint8_t handleManualControl(const uint8_t * payload);
+
+	/**
+	 * @brief Commit a frame and count the result
+	 */
+	uint8_t commit(const float values[6], uint8_t channelMask);
+
+public:
+	/**
+	 * @brief Prepare a parser for the given emulator
+	 * 
+	 * @param controller The emulator to command
+	 * @param systemId The system id of the emulated vehicle, 0 to accept messages for any system
+	 */
+	MavlinkIngest(FlightControlEmulator * controller, uint8_t systemId);
+
+	MavlinkIngest(FlightControlEmulator * controller) : MavlinkIngest(controller, 1) {}
+
+	/**
+	 * @brief Feed one byte of the stream, for serial links
+	 * 
+	 * @param byte The next byte
+	 * 
+	 * @return
+	 *     - 1 the byte completed a command that was committed
+	 *     - 0 otherwise
+	 */
+	uint8_t parse(uint8_t byte);
+
+	/**
+	 * @brief Feed one datagram, any frame left unfinished by the previous datagram is dropped first since
+	 * MAVLink frames never span datagrams
+	 * 
+	 * @param bytes The datagram
+	 * @param length The number of bytes in the datagram
+	 * 
+	 * @return The number of commands committed
+	 */
+	uint16_t parse(const uint8_t * bytes, uint16_t length);
+
+	/**
+	 * @brief Count a datagram the transport had to cut short, its frames are dropped rather than parsed
+	 */
+	void countTruncated() { this->truncatedDatagrams++; }
+
+	/**
+	 * @brief Get the parser and command counters
+	 */
+	mavlink_ingest_stats_t getStats();
+};
+
+
+/**
+ * @brief Reads MAVLink datagrams from a loopback UDP port in batches with recvmmsg, for host builds
+ * @note Only available on Linux, open() fails everywhere else
+ */
+class MavlinkUdpReceiver
+{
+protected:
+	//Parser the datagrams are fed to
+	MavlinkIngest * ingest;
+
+	//Bound socket, -1 when closed
+	int socketHandle;
+
+	//Receive buffers for one batch
+	uint8_t buffers[MAVLINK_UDP_BATCH][MAVLINK_MAX_PAYLOAD + 25];
+
+public:
+	MavlinkUdpReceiver(MavlinkIngest * ingest) : ingest(ingest), socketHandle(-1) {}
+
+	~MavlinkUdpReceiver() { this->close(); }
+
+	/**
+	 * @brief Bind a non-blocking socket to 127.0.0.1 on the given port
+	 * 
+	 * @param port The UDP port
+	 * 
+	 * @return
+	 *     - 1 the socket is ready
+	 *     - 0 the socket could not be created or bound
+	 */
+	uint8_t open(uint16_t port);
+
+	uint8_t open() { return this->open(MAVLINK_UDP_DEFAULT_PORT); }
+
+	/**
+	 * @brief Close the socket
+	 */
+	void close();
+
+	/**
+	 * @brief Read every datagram waiting, up to MAVLINK_UDP_BATCH per system call, and feed them to the parser,
+	 * datagrams too long for a receive buffer are counted as truncated instead
+	 * 
+	 * @param timeoutMillis How long to wait for the first datagram, 0 to return immediately
+	 * 
+	 * @return The number of datagrams read, including truncated ones
+	 */
+	int receive(int timeoutMillis);
+};
+
+#endif
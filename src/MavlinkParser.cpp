@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+#include "MavlinkParser.h"
+
+/**
+ * @brief CRC_EXTRA table entry, the seed added to the checksum of each message type and its full payload length
+ */
+typedef struct
+{
+	uint32_t id;
+	uint8_t crcExtra;
+	uint8_t length;
+} mavlink_message_info_t;
+
+static const mavlink_message_info_t messageInfo[] =
+{
+	{ MAVLINK_MSG_ID_HEARTBEAT, MAVLINK_MSG_ID_HEARTBEAT_CRC, MAVLINK_MSG_ID_HEARTBEAT_LEN },
+	{ MAVLINK_MSG_ID_MANUAL_CONTROL, MAVLINK_MSG_ID_MANUAL_CONTROL_CRC, MAVLINK_MSG_ID_MANUAL_CONTROL_LEN },
+	{ MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE, MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_CRC, MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_LEN }
+};
+
+//CRC-16/MCRF4XX as used by MAVLink
+static uint16_t crcAccumulate(uint8_t byte, uint16_t crc)
+{
+	uint8_t tmp = byte ^ (uint8_t) (crc & 0xFF);
+	tmp ^= (tmp << 4);
+
+	return (crc >> 8) ^ (tmp << 8) ^ (tmp << 3) ^ (tmp >> 4);
+}
+
+MavlinkParser::MavlinkParser()
+{
+	this->frameLength = 0;
+	this->frameExpected = 0;
+	memset(&this->message, 0, sizeof(this->message));
+	memset(&this->stats, 0, sizeof(this->stats));
+}
+
+uint8_t MavlinkParser::parse(uint8_t byte)
+{
+	if(this->frameLength == 0)
+	{
+		if(byte != MAVLINK_STX_V1 && byte != MAVLINK_STX_V2)
+		{
+			this->stats.droppedBytes++;
+			return 0;
+		}
+
+		this->frameExpected = 0;
+	}
+
+	this->frame[this->frameLength++] = byte;
+
+	//The total length is known once the payload length, and for v2 the signing flag, have arrived
+	if(this->frameExpected == 0)
+	{
+		if(this->frame[0] == MAVLINK_STX_V1 && this->frameLength == 2)
+			this->frameExpected = MAVLINK_HEADER_V1 + this->frame[1] + 2;
+		else if(this->frame[0] == MAVLINK_STX_V2 && this->frameLength == 3)
+			this->frameExpected = MAVLINK_HEADER_V2 + this->frame[1] + 2 + ((this->frame[2] & MAVLINK_IFLAG_SIGNED) ? MAVLINK_SIGNATURE_LENGTH : 0);
+
+		return 0;
+	}
+
+	if(this->frameLength < this->frameExpected)
+		return 0;
+
+	uint8_t result = this->checkFrame();
+	this->frameLength = 0;
+
+	return result;
+}
+
+void MavlinkParser::dropPartialFrame()
+{
+	this->stats.droppedBytes += this->frameLength;
+	this->frameLength = 0;
+}
+
+uint8_t MavlinkParser::checkFrame()
+{
+	uint8_t version2 = this->frame[0] == MAVLINK_STX_V2;
+	uint8_t headerLength = version2 ? MAVLINK_HEADER_V2 : MAVLINK_HEADER_V1;
+	uint8_t payloadLength = this->frame[1];
+
+	//An unknown incompatibility flag may change the framing, so nothing in the frame can be trusted
+	if(version2 && (this->frame[2] & ~MAVLINK_IFLAGS_SUPPORTED))
+	{
+		this->stats.incompatibleFrames++;
+		return 0;
+	}
+
+	uint32_t id = version2 ? (this->frame[7] | (this->frame[8] << 8) | ((uint32_t) this->frame[9] << 16)) : this->frame[5];
+
+	const mavlink_message_info_t * info = NULL;
+	for(uint16_t i = 0; i < sizeof(messageInfo) / sizeof(messageInfo[0]); i++)
+	{
+		if(messageInfo[i].id == id)
+		{
+			info = &messageInfo[i];
+			break;
+		}
+	}
+
+	if(info == NULL)
+	{
+		this->stats.unknownMessages++;
+		return 0;
+	}
+
+	uint16_t crc = 0xFFFF;
+	for(int i = 1; i < headerLength + payloadLength; i++)
+		crc = crcAccumulate(this->frame[i], crc);
+	crc = crcAccumulate(info->crcExtra, crc);
+
+	uint16_t received = this->frame[headerLength + payloadLength] | (this->frame[headerLength + payloadLength + 1] << 8);
+
+	if(crc != received)
+	{
+		this->stats.checksumErrors++;
+		return 0;
+	}
+
+	this->stats.frames++;
+
+	this->message.id = id;
+	this->message.systemId = this->frame[version2 ? 5 : 3];
+	this->message.componentId = this->frame[version2 ? 6 : 4];
+
+	memset(this->message.payload, 0, sizeof(this->message.payload));
+	memcpy(this->message.payload, &this->frame[headerLength], payloadLength < info->length ? payloadLength : info->length);
+
+	return 1;
+}
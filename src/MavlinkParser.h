@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef MAVLINKPARSER_H
+#define MAVLINKPARSER_H
+
+#include <stdint.h>
+
+#define MAVLINK_STX_V1 0xFE
+#define MAVLINK_STX_V2 0xFD
+#define MAVLINK_MAX_PAYLOAD 255
+#define MAVLINK_SIGNATURE_LENGTH 13
+#define MAVLINK_HEADER_V1 6
+#define MAVLINK_HEADER_V2 10
+
+//incompat_flags bits, v2 frames with any bit other than these set cannot be parsed and are dropped
+#define MAVLINK_IFLAG_SIGNED 0x01
+#define MAVLINK_IFLAGS_SUPPORTED MAVLINK_IFLAG_SIGNED
+
+#define MAVLINK_MSG_ID_HEARTBEAT 0
+#define MAVLINK_MSG_ID_HEARTBEAT_LEN 9
+#define MAVLINK_MSG_ID_HEARTBEAT_CRC 50
+#define MAVLINK_MSG_ID_MANUAL_CONTROL 69
+#define MAVLINK_MSG_ID_MANUAL_CONTROL_LEN 11
+#define MAVLINK_MSG_ID_MANUAL_CONTROL_CRC 243
+#define MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE 70
+#define MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_LEN 38
+#define MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_CRC 124
+
+//Longest full payload of the messages in the CRC_EXTRA table
+#define MAVLINK_KNOWN_PAYLOAD_MAXIMUM MAVLINK_MSG_ID_RC_CHANNELS_OVERRIDE_LEN
+
+/**
+ * @brief Counters kept by the MAVLink parser
+ */
+typedef struct
+{
+	//Frames with a valid checksum, of a message in the CRC_EXTRA table
+	uint32_t frames;
+
+	//Frames of a message in the CRC_EXTRA table dropped for a bad checksum
+	uint32_t checksumErrors;
+
+	//Bytes skipped while looking for the start of a frame, or left in a frame a datagram cut short
+	uint32_t droppedBytes;
+
+	//Complete frames of messages missing from the CRC_EXTRA table, whose checksum cannot be checked
+	uint32_t unknownMessages;
+
+	//v2 frames dropped for incompat_flags bits the parser does not understand
+	uint32_t incompatibleFrames;
+} mavlink_parser_stats_t;
+
+/**
+ * @brief A checked message as handed out by MavlinkParser
+ */
+typedef struct
+{
+	uint32_t id;
+	uint8_t systemId;
+	uint8_t componentId;
+
+	//The payload, zero extended to the full length of the message since v2 senders drop trailing zero bytes
+	//and v1 senders leave out extension fields
+	uint8_t payload[MAVLINK_KNOWN_PAYLOAD_MAXIMUM];
+} mavlink_parsed_message_t;
+
+/**
+ * @brief Frames and checks a MAVLink v1/v2 byte stream without allocation, handing out the messages of its
+ * CRC_EXTRA table
+ */
+class MavlinkParser
+{
+protected:
+	//Frame being received
+	uint8_t frame[MAVLINK_HEADER_V2 + MAVLINK_MAX_PAYLOAD + 2 + MAVLINK_SIGNATURE_LENGTH];
+	uint16_t frameLength;
+	uint16_t frameExpected;
+
+	//The last message completed
+	mavlink_parsed_message_t message;
+
+	mavlink_parser_stats_t stats;
+
+	/**
+	 * @brief Check a complete frame and unpack it into message
+	 * 
+	 * @return
+	 *     - 1 the frame holds a valid message from the CRC_EXTRA table
+	 *     - 0 the frame was dropped
+	 */
+	uint8_t checkFrame();
+
+public:
+	MavlinkParser();
+
+	/**
+	 * @brief Feed one byte of the stream
+	 * 
+	 * @param byte The next byte
+	 * 
+	 * @return
+	 *     - 1 the byte completed a valid message, read it with getMessage
+	 *     - 0 otherwise
+	 */
+	uint8_t parse(uint8_t byte);
+
+	/**
+	 * @brief Drop a partly received frame, counting its bytes as dropped, for the start of a new datagram
+	 */
+	void dropPartialFrame();
+
+	/**
+	 * @brief Check whether a frame is partly received
+	 */
+	uint8_t receiving() { return this->frameLength != 0; }
+
+	/**
+	 * @brief Get the last message completed by parse
+	 */
+	const mavlink_parsed_message_t & getMessage() { return this->message; }
+
+	/**
+	 * @brief Get the parser counters
+	 */
+	mavlink_parser_stats_t getStats() { return this->stats; }
+};
+
+#endif
@@ -20,7 +20,37 @@
  * SOFTWARE.
  */
 #include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
 #include "PWMHandler.h"
+#include "FlightClock.h"
+#include "TraceRecorder.h"
+
+//Stack for the task that brings up the second unit during a parallel init
+#define PWM_INIT_TASK_STACK 2048
+
+//Longest wait for a DShot frame in flight to finish, at least one full tick and far longer than the slowest frame
+#define PWM_DSHOT_WAIT_TICKS 2
+
+/**
+ * @brief Work handed to the task bringing up the second unit during a parallel init
+ */
+typedef struct
+{
+	PWMHandler * handler;
+	uint8_t channelMask;
+	pwm_init_timing_t timing;
+	pwm_state result;
+	SemaphoreHandle_t done;
+} pwm_unit_init_t;
+
+//Whether a mode is sent on the RMT rather than the MCPWM
+static inline uint8_t isDShotMode(pwm_output_mode mode)
+{
+	return mode == PWM_MODE_DSHOT150 || mode == PWM_MODE_DSHOT300 || mode == PWM_MODE_DSHOT600;
+}
+
 PWMHandler::PWMHandler(mcpwm_unit_t pwmUnit1, mcpwm_unit_t pwmUnit2, int channel1, int channel2, int channel3, int channel4, int channel5, int channel6)
 {
 	if(pwmUnit1 >= MCPWM_UNIT_MAX)
@@ -79,85 +109,214 @@ PWMHandler::PWMHandler(mcpwm_unit_t pwmUnit1, mcpwm_unit_t pwmUnit2, int channel
 
 	for(int i = 0; i < 6; i++)
 		this->currentDutys[i] = 0.0;
-}
-
-pwm_state PWMHandler::init()
-{
-	mcpwm_gpio_init(this->pwmUnits[0], MCPWM_SYNC_0, PIN_A0);
-	mcpwm_gpio_init(this->pwmUnits[1], MCPWM_SYNC_0, PIN_A0);
 
-	//Initialize pins
 	for(int i = 0; i < 6; i++)
 	{
-		if(mcpwm_gpio_init(this->unitChannelMap[i], this->mcpwmChannelMap[i], this->channelPins[i]) != ESP_OK)
-			return PWM_FAILURE;
+		this->channelModes[i] = PWM_MODE_SERVO;
+		this->dshotEncoders[i] = NULL;
 	}
 
-	//Initialize timer configs
-	for(int i = 0; i < 3; i++)
-	{
-		if(mcpwm_init(this->pwmUnits[0], (mcpwm_timer_t) i, &this->configurationData[i]) != ESP_OK)
-			return PWM_FAILURE;
-	}
+	for(int i = 0; i < PWM_GROUP_COUNT; i++)
+		this->groupFrequencies[i] = PWM_DEFAULT_APPROX_FREQUENCY_HZ;
+
+	for(int i = 0; i < 6; i++)
+		this->channelGroups[i] = 0;
 
-	for(int i = 0; i < 3; i++)
+	this->initTiming = pwm_init_timing_t();
+	this->clock = FlightClock::system();
+}
+
+PWMHandler::~PWMHandler()
+{
+	for(int i = 0; i < 6; i++)
 	{
-		if(mcpwm_init(this->pwmUnits[1], (mcpwm_timer_t) i, &this->configurationData[i + 3]) != ESP_OK)
-			return PWM_FAILURE;
+		if(this->dshotEncoders[i] == NULL)
+			continue;
+
+		rmt_tx_stop((rmt_channel_t) i);
+		rmt_driver_uninstall((rmt_channel_t) i);
+
+		delete this->dshotEncoders[i];
+		this->dshotEncoders[i] = NULL;
 	}
+}
+
+pwm_state PWMHandler::init(uint8_t channelMask)
+{
+	uint64_t startTime = this->clock->now();
+
+	this->initTiming.syncMicros = 0;
+	this->initTiming.gpioMicros = 0;
+	this->initTiming.timerMicros = 0;
+	this->initTiming.driverCalls = 0;
 
-	//Set default frequency
-	for(int i = 0; i < 3; i++)
+	//The timer frequency is set by mcpwm_init from configurationData, channels outside the mask wait for first use
+	uint8_t parallelMask = 0;
+	pwm_unit_init_t unitInit;
+
+#if portNUM_PROCESSORS > 1
+	if(this->parallelInit && this->pwmUnits[0] != this->pwmUnits[1] && (channelMask & 0x38) && (channelMask & 0x07))
 	{
-		if(mcpwm_set_frequency(this->pwmUnits[0], (mcpwm_timer_t) i, PWM_DEFAULT_APPROX_FREQUENCY_HZ) != ESP_OK)
-			return PWM_FAILURE;
+		unitInit.handler = this;
+		unitInit.channelMask = channelMask & 0x38;
+		unitInit.timing = pwm_init_timing_t();
+		unitInit.result = PWM_FAILURE;
+		unitInit.done = xSemaphoreCreateBinary();
+
+		if(unitInit.done != NULL && xTaskCreatePinnedToCore(PWMHandler::prepareUnitTask, "pwm_init", PWM_INIT_TASK_STACK, &unitInit,
+			uxTaskPriorityGet(NULL), NULL, xPortGetCoreID() ^ 1) == pdPASS)
+			parallelMask = unitInit.channelMask;
+		else if(unitInit.done != NULL)
+			vSemaphoreDelete(unitInit.done);
 	}
+#endif
 
-	for(int i = 0; i < 3; i++)
+	pwm_state result = this->prepareChannels(channelMask & ~parallelMask, &this->initTiming);
+
+	if(parallelMask)
 	{
-		if(mcpwm_set_frequency(this->pwmUnits[1], (mcpwm_timer_t) i, PWM_DEFAULT_APPROX_FREQUENCY_HZ) != ESP_OK)
-			return PWM_FAILURE;
+		xSemaphoreTake(unitInit.done, portMAX_DELAY);
+		vSemaphoreDelete(unitInit.done);
+
+		this->initTiming.syncMicros += unitInit.timing.syncMicros;
+		this->initTiming.gpioMicros += unitInit.timing.gpioMicros;
+		this->initTiming.timerMicros += unitInit.timing.timerMicros;
+		this->initTiming.driverCalls += unitInit.timing.driverCalls;
+
+		if(unitInit.result != PWM_SUCCESS)
+			result = PWM_FAILURE;
 	}
 
+	if(result != PWM_SUCCESS)
+		return PWM_FAILURE;
+
 	this->pwmFrequency = PWM_DEFAULT_APPROX_FREQUENCY_HZ;
 
 	this->initCalled = 1;
 
+	this->initTiming.totalMicros = this->clock->now() - startTime;
+
 	return PWM_SUCCESS;
 }
 
-pwm_state PWMHandler::start()
+pwm_state PWMHandler::prepareChannels(uint8_t channelMask, pwm_init_timing_t * timing)
 {
-	for(int i = 0; i < 3; i++)
+	for(int i = 0; i < 6; i++)
 	{
-		if(mcpwm_start(this->pwmUnits[0], (mcpwm_timer_t) i) != ESP_OK)
+		if((channelMask & (1 << i)) && this->prepareChannel(i, timing) != PWM_SUCCESS)
 			return PWM_FAILURE;
 	}
 
-	for(int i = 0; i < 3; i++)
+	return PWM_SUCCESS;
+}
+
+void PWMHandler::prepareUnitTask(void * arg)
+{
+	pwm_unit_init_t * unitInit = (pwm_unit_init_t *) arg;
+
+	unitInit->result = unitInit->handler->prepareChannels(unitInit->channelMask, &unitInit->timing);
+	xSemaphoreGive(unitInit->done);
+
+	vTaskDelete(NULL);
+}
+
+pwm_state PWMHandler::prepareChannel(int channelIndex, pwm_init_timing_t * timing)
+{
+	//DShot channels are driven by the RMT and never configured on the MCPWM
+	if((this->channelsReady & (1 << channelIndex)) || this->dshotEncoders[channelIndex] != NULL)
+		return PWM_SUCCESS;
+
+	FlightClock * clock = this->clock;
+	uint64_t phaseStart = clock->now();
+	int unitIndex = channelIndex / 3;
+
+	if(!(this->unitsSynced & (1 << unitIndex)))
 	{
-		if(mcpwm_start(this->pwmUnits[1], (mcpwm_timer_t) i) != ESP_OK)
+		if(FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_GPIO_INIT, mcpwm_gpio_init(this->pwmUnits[unitIndex], MCPWM_SYNC_0, PIN_A0)) != ESP_OK)
 			return PWM_FAILURE;
+
+		//Each unit is only ever prepared from one core at a time, but the two units may be prepared concurrently
+		__atomic_fetch_or(&this->unitsSynced, 1 << unitIndex, __ATOMIC_RELAXED);
+
+		if(timing != NULL)
+		{
+			timing->driverCalls++;
+			timing->syncMicros += clock->now() - phaseStart;
+			phaseStart = clock->now();
+		}
+	}
+
+	if(FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_GPIO_INIT, mcpwm_gpio_init(this->unitChannelMap[channelIndex], this->mcpwmChannelMap[channelIndex], this->channelPins[channelIndex])) != ESP_OK)
+		return PWM_FAILURE;
+
+	if(timing != NULL)
+	{
+		timing->driverCalls++;
+		timing->gpioMicros += clock->now() - phaseStart;
+		phaseStart = clock->now();
+	}
+
+	if(FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_INIT, mcpwm_init(this->unitChannelMap[channelIndex], (mcpwm_timer_t) (channelIndex % 3), &this->configurationData[channelIndex])) != ESP_OK)
+		return PWM_FAILURE;
+
+	if(timing != NULL)
+	{
+		timing->driverCalls++;
+		timing->timerMicros += clock->now() - phaseStart;
 	}
 
+	if(this->running && FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_START, mcpwm_start(this->unitChannelMap[channelIndex], (mcpwm_timer_t) (channelIndex % 3))) != ESP_OK)
+		return PWM_FAILURE;
+
+	__atomic_fetch_or(&this->channelsReady, 1 << channelIndex, __ATOMIC_RELAXED);
+
 	return PWM_SUCCESS;
 }
 
-pwm_state PWMHandler::stop()
+pwm_state PWMHandler::start()
 {
-	for(int i = 0; i < 3; i++)
+	for(int i = 0; i < 6; i++)
 	{
-		if(mcpwm_set_duty(this->pwmUnits[0], (mcpwm_timer_t) i, MCPWM_OPR_A, 0) != ESP_OK || mcpwm_stop(this->pwmUnits[0], (mcpwm_timer_t) i) != ESP_OK)
+		if((this->channelsReady & (1 << i)) && FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_START, mcpwm_start(this->unitChannelMap[i], (mcpwm_timer_t) (i % 3))) != ESP_OK)
+			return PWM_FAILURE;
+
+		//DShot channels loop the frame loaded while stopped
+		if(this->dshotEncoders[i] != NULL &&
+			(FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_RMT_SET_TX_LOOP_MODE, rmt_set_tx_loop_mode((rmt_channel_t) i, true)) != ESP_OK ||
+			FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_RMT_TX_START, rmt_tx_start((rmt_channel_t) i, true)) != ESP_OK))
 			return PWM_FAILURE;
 	}
 
-	for(int i = 0; i < 3; i++)
+	this->running = 1;
+
+	return PWM_SUCCESS;
+}
+
+pwm_state PWMHandler::stop()
+{
+	for(int i = 0; i < 6; i++)
 	{
-		if(mcpwm_set_duty(this->pwmUnits[1], (mcpwm_timer_t) i, MCPWM_OPR_A, 0) != ESP_OK || mcpwm_stop(this->pwmUnits[1], (mcpwm_timer_t) i) != ESP_OK)
+		//Disarm DShot ESCs rather than leaving the last throttle frame repeating, then let the disarm frame finish
+		//and leave the channel quiet
+		if(this->dshotEncoders[i] != NULL)
+		{
+			if(this->writeDShot(i, 0) != PWM_SUCCESS ||
+				FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_RMT_SET_TX_LOOP_MODE, rmt_set_tx_loop_mode((rmt_channel_t) i, false)) != ESP_OK ||
+				FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_RMT_WAIT_TX_DONE, rmt_wait_tx_done((rmt_channel_t) i, PWM_DSHOT_WAIT_TICKS)) != ESP_OK)
+				return PWM_FAILURE;
+
+			continue;
+		}
+
+		if(!(this->channelsReady & (1 << i)))
+			continue;
+
+		if(FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_SET_DUTY, mcpwm_set_duty(this->unitChannelMap[i], (mcpwm_timer_t) (i % 3), MCPWM_OPR_A, 0)) != ESP_OK ||
+			FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_STOP, mcpwm_stop(this->unitChannelMap[i], (mcpwm_timer_t) (i % 3))) != ESP_OK)
 			return PWM_FAILURE;
 	}
 
-
+	this->running = 0;
 
 	return PWM_SUCCESS;
 }
@@ -179,32 +338,374 @@ pwm_state PWMHandler::setDuty(int channel, float dutyPercentage)
 	if(channel < 1 || channel > 6)
 		return PWM_INVALID_CHANNEL;
 
+	FCE_TRACE_SCOPE(TRACE_SET_DUTY, channel);
+
 	channel --;
+	if(this->dshotEncoders[channel] != NULL)
+		return PWM_INVALID_CHANNEL;
+
 	this->currentDutys[channel] = dutyPercentage;
+
+	if(this->prepareChannel(channel, NULL) != PWM_SUCCESS)
+		return PWM_FAILURE;
+
+	//ESC channels free run at their own rate
+	if(this->channelModes[channel] != PWM_MODE_SERVO)
+		return FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_SET_DUTY, mcpwm_set_duty(this->unitChannelMap[channel], (mcpwm_timer_t) (channel%3), MCPWM_OPR_A, dutyPercentage)) == ESP_OK ? PWM_SUCCESS : PWM_FAILURE;
 	
-	for(int i = channel; i < 6; i++)
+	return this->applyGroupChain(channel);
+}
+
+pwm_state PWMHandler::applyGroupChain(int channelIndex)
+{
+	uint8_t group = this->channelGroups[channelIndex];
+
+	//The first configured servo channel of a group other than 0 free runs and clocks the rest of its chain
+	int lead = -1;
+	float delayPercent = 0;
+
+	for(int i = 0; i < 6; i++)
+	{
+		//Other groups and ESC channels run on their own timing
+		if(this->channelModes[i] != PWM_MODE_SERVO || this->channelGroups[i] != group)
+			continue;
+
+		uint8_t ready = (this->channelsReady & (1 << i)) != 0;
+		if(lead < 0 && ready)
+			lead = i;
+
+		//Channels that have never been used are not configured yet
+		if(i >= channelIndex && ready)
+		{
+			mcpwm_unit_t unit = this->unitChannelMap[i];
+			mcpwm_timer_t timer = (mcpwm_timer_t) (i%3);
+
+			//Loaded on sync so the pulse starts once the earlier pulses of the chain have ended, a full period wraps to 0
+			uint32_t phase = (uint32_t) (1000 - delayPercent * 10) % 1000;
+			esp_err_t result;
+
+			if(group == 0)
+				result = FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_SYNC_ENABLE, mcpwm_sync_enable(unit, timer, MCPWM_SELECT_SYNC0, phase));
+			else if(i == lead)
+			{
+				result = FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_SYNC_DISABLE, mcpwm_sync_disable(unit, timer));
+				if(result == ESP_OK)
+					result = FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_SYNC_OUTPUT, mcpwm_set_timer_sync_output(unit, timer, MCPWM_SWSYNC_SOURCE_TEZ));
+			}
+			else
+			{
+				mcpwm_sync_config_t syncConfig = {};
+				syncConfig.sync_sig = (mcpwm_sync_signal_t) (MCPWM_SELECT_TIMER0_SYNC + lead % 3);
+				syncConfig.timer_val = phase;
+				syncConfig.count_direction = MCPWM_TIMER_DIRECTION_UP;
+				result = FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_SYNC_ENABLE, mcpwm_sync_configure(unit, timer, &syncConfig));
+			}
+
+			if(result != ESP_OK)
+				return PWM_FAILURE;
+
+			if(FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_SET_DUTY, mcpwm_set_duty(unit, timer, MCPWM_OPR_A, this->currentDutys[i])) != ESP_OK)
+				return PWM_FAILURE;
+		}
+
+		delayPercent += this->currentDutys[i];
+	}
+
+	return PWM_SUCCESS;
+}
+
+uint8_t PWMHandler::groupChainFits(uint8_t group, uint32_t frequencyHz, int channelIndex)
+{
+	//Channel ranges are duty cycles at the default rate, scaled to the group rate they give the share of the frame
+	float framePercent = 0;
+
+	for(int i = 0; i < 6; i++)
+	{
+		if(i == channelIndex || (this->channelGroups[i] == group && this->channelModes[i] == PWM_MODE_SERVO))
+			framePercent += this->channelMaximums[i];
+	}
+
+	return framePercent * frequencyHz / PWM_DEFAULT_APPROX_FREQUENCY_HZ <= 100;
+}
+
+pwm_state PWMHandler::setChannelGroup(int channel, uint8_t group)
+{
+	if(channel < 1 || channel > 6 || group >= PWM_GROUP_COUNT)
+		return PWM_INVALID_CHANNEL;
+
+	channel --;
+	uint8_t oldGroup = this->channelGroups[channel];
+	if(oldGroup == group)
+		return PWM_SUCCESS;
+
+	//Only group 0 has a sync signal shared by both units, the others are clocked by a timer of their own unit
+	for(int i = 0; group != 0 && i < 6; i++)
 	{
-		float delayPercent = 0;
+		if(i != channel && this->channelGroups[i] == group && this->unitChannelMap[i] != this->unitChannelMap[channel])
+			return PWM_INVALID_CHANNEL;
+	}
+
+	if(this->channelModes[channel] == PWM_MODE_SERVO && !this->groupChainFits(group, this->groupFrequencies[group], channel))
+		return PWM_RATE_TOO_HIGH;
+
+	this->channelGroups[channel] = group;
+
+	if(this->channelModes[channel] != PWM_MODE_SERVO)
+		return PWM_SUCCESS;
+
+	//Keep the same pulse width at the new group rate
+	this->currentDutys[channel] *= (float) this->groupFrequencies[group] / this->groupFrequencies[oldGroup];
+	this->configurationData[channel].frequency = this->groupFrequencies[group];
+
+	if(this->channelsReady & (1 << channel))
+	{
+		if(FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_SET_FREQUENCY, mcpwm_set_frequency(this->unitChannelMap[channel], (mcpwm_timer_t) (channel%3), this->groupFrequencies[group])) != ESP_OK)
+			return PWM_FAILURE;
+	}
+
+	//Close the gap left in the old chain and slot into the new one
+	for(int i = 0; i < 6; i++)
+	{
+		if(this->channelGroups[i] == oldGroup)
+		{
+			if(this->applyGroupChain(i) != PWM_SUCCESS)
+				return PWM_FAILURE;
+			break;
+		}
+	}
+
+	return this->applyGroupChain(channel);
+}
+
+pwm_state PWMHandler::setGroupFrequency(uint8_t group, uint32_t frequencyHz)
+{
+	if(group >= PWM_GROUP_COUNT || frequencyHz == 0)
+		return PWM_INVALID_CHANNEL;
+
+	if(!this->groupChainFits(group, frequencyHz, -1))
+		return PWM_RATE_TOO_HIGH;
+
+	float scale = (float) frequencyHz / this->groupFrequencies[group];
+	this->groupFrequencies[group] = frequencyHz;
+
+	int firstChannel = -1;
+
+	for(int i = 0; i < 6; i++)
+	{
+		if(this->channelGroups[i] != group || this->channelModes[i] != PWM_MODE_SERVO)
+			continue;
+
+		if(firstChannel < 0)
+			firstChannel = i;
+
+		//Keep the same pulse width at the new rate
+		this->currentDutys[i] *= scale;
+		this->configurationData[i].frequency = frequencyHz;
+
+		if((this->channelsReady & (1 << i)) && FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_SET_FREQUENCY, mcpwm_set_frequency(this->unitChannelMap[i], (mcpwm_timer_t) (i%3), frequencyHz)) != ESP_OK)
+			return PWM_FAILURE;
+	}
+
+	if(firstChannel < 0)
+		return PWM_SUCCESS;
+
+	return this->applyGroupChain(firstChannel);
+}
+
+pwm_state PWMHandler::setChannelMode(int channel, pwm_output_mode mode)
+{
+	if(channel < 1 || channel > 6)
+		return PWM_INVALID_CHANNEL;
+
+	channel --;
+	mcpwm_timer_t timer = (mcpwm_timer_t) (channel%3);
+	rmt_channel_t rmtChannel = (rmt_channel_t) channel;
+
+	if(mode == PWM_MODE_SERVO && this->channelModes[channel] != PWM_MODE_SERVO &&
+		!this->groupChainFits(this->channelGroups[channel], this->groupFrequencies[this->channelGroups[channel]], channel))
+		return PWM_RATE_TOO_HIGH;
+
+	//Hand the pin back from the RMT, prepareChannel routes it to the MCPWM again on next use
+	if(this->dshotEncoders[channel] != NULL)
+	{
+		FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_RMT_TX_STOP, rmt_tx_stop(rmtChannel));
+		if(FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_RMT_DRIVER_UNINSTALL, rmt_driver_uninstall(rmtChannel)) != ESP_OK)
+			return PWM_FAILURE;
+
+		delete this->dshotEncoders[channel];
+		this->dshotEncoders[channel] = NULL;
+	}
+
+	this->channelModes[channel] = mode;
+	this->currentDutys[channel] = 0;
+
+	if(isDShotMode(mode))
+	{
+		if(this->channelsReady & (1 << channel))
+		{
+			if(FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_STOP, mcpwm_stop(this->unitChannelMap[channel], timer)) != ESP_OK)
+				return PWM_FAILURE;
+
+			this->channelsReady &= ~(1 << channel);
+		}
+
+		rmt_config_t config = {};
+		config.rmt_mode = RMT_MODE_TX;
+		config.channel = rmtChannel;
+		config.gpio_num = this->channelPins[channel];
+		config.clk_div = 1;
+		config.mem_block_num = 1;
+		config.tx_config.loop_en = true;
+		config.tx_config.idle_output_en = true;
+		config.tx_config.idle_level = RMT_IDLE_LEVEL_LOW;
+
+		if(FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_RMT_CONFIG, rmt_config(&config)) != ESP_OK ||
+			FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_RMT_DRIVER_INSTALL, rmt_driver_install(rmtChannel, 0, 0)) != ESP_OK)
+			return PWM_FAILURE;
+
+		this->dshotEncoders[channel] = new DShotEncoder(mode == PWM_MODE_DSHOT150 ? 150 : (mode == PWM_MODE_DSHOT300 ? 300 : 600));
+
+		//Load a disarm frame, it only goes out while the outputs are running
+		return this->writeDShot(channel, 0);
+	}
+
+	if(mode == PWM_MODE_ONESHOT125)
+		this->configurationData[channel].frequency = PWM_ONESHOT125_FREQUENCY_HZ;
+	else if(mode == PWM_MODE_MULTISHOT)
+		this->configurationData[channel].frequency = PWM_MULTISHOT_FREQUENCY_HZ;
+	else
+		this->configurationData[channel].frequency = this->groupFrequencies[this->channelGroups[channel]];
 
-		for(int j = 0; j < i; j++)
-			delayPercent += this->currentDutys[j];
+	if(this->channelsReady & (1 << channel))
+	{
+		if(FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_SET_FREQUENCY, mcpwm_set_frequency(this->unitChannelMap[channel], timer, this->configurationData[channel].frequency)) != ESP_OK)
+			return PWM_FAILURE;
 
-		if(mcpwm_sync_enable(this->unitChannelMap[i], (mcpwm_timer_t) (i%3), MCPWM_SELECT_SYNC0, int(1000-delayPercent*10)) != ESP_OK)
+		//ESC channels free run instead of following the servo phase chain
+		if(mode != PWM_MODE_SERVO && FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_SYNC_DISABLE, mcpwm_sync_disable(this->unitChannelMap[channel], timer)) != ESP_OK)
+			return PWM_FAILURE;
+	}
+
+	return PWM_SUCCESS;
+}
+
+pwm_state PWMHandler::writeDShot(int channelIndex, float percentage)
+{
+	rmt_channel_t rmtChannel = (rmt_channel_t) channelIndex;
+	uint16_t value = DShotEncoder::throttleValue(percentage);
+
+	rmt_item32_t items[DSHOT_FRAME_SYMBOLS];
+	this->dshotEncoders[channelIndex]->encode(DShotEncoder::packet(value, 0), (uint32_t *) items);
+
+	//A stopped channel is not transmitting, the frame only needs to be in memory when start begins the loop
+	if(!this->running)
+	{
+		if(FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_RMT_FILL_TX_ITEMS, rmt_fill_tx_items(rmtChannel, items, DSHOT_FRAME_SYMBOLS, 0)) != ESP_OK)
+			return PWM_FAILURE;
+	}
+	else
+	{
+		//Rewriting channel memory while the loop plays it out could put half of each frame on the wire, so let the
+		//frame in flight finish at its end marker, then write and loop the new one
+		if(FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_RMT_SET_TX_LOOP_MODE, rmt_set_tx_loop_mode(rmtChannel, false)) != ESP_OK ||
+			FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_RMT_WAIT_TX_DONE, rmt_wait_tx_done(rmtChannel, PWM_DSHOT_WAIT_TICKS)) != ESP_OK ||
+			FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_RMT_SET_TX_LOOP_MODE, rmt_set_tx_loop_mode(rmtChannel, true)) != ESP_OK)
 			return PWM_FAILURE;
 
-		if(mcpwm_set_duty(this->unitChannelMap[i], (mcpwm_timer_t) (i%3), MCPWM_OPR_A, this->currentDutys[i]) != ESP_OK)
+		if(FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_RMT_WRITE_ITEMS, rmt_write_items(rmtChannel, items, DSHOT_FRAME_SYMBOLS, false)) != ESP_OK)
 			return PWM_FAILURE;
 	}
 
+	//Report where the value sits in the throttle range, as the duty of the equivalent analog signal
+	this->currentDutys[channelIndex] = value < DSHOT_VALUE_MINIMUM ? 0 :
+		(float) (value - DSHOT_VALUE_MINIMUM) * 100 / (DSHOT_VALUE_MAXIMUM - DSHOT_VALUE_MINIMUM);
+
 	return PWM_SUCCESS;
 }
 
 pwm_state PWMHandler::setChannelOutput(int channel, float percentage)
 {
+	if(channel < 1 || channel > 6)
+		return PWM_INVALID_CHANNEL;
+
 	if(percentage < 0 || percentage > 100)
 		return PWM_OUT_OF_RC_Range;
 
-	return setDuty(channel, (this->channelMaximums[channel - 1] - this->channelMinimums[channel - 1]) * .01 * percentage + this->channelMinimums[channel - 1]);
+	if(isDShotMode(this->channelModes[channel - 1]))
+		return writeDShot(channel - 1, percentage);
+
+	return setDuty(channel, this->outputDuty(channel - 1, percentage));
+}
+
+float PWMHandler::outputDuty(int channelIndex, float percentage)
+{
+	//Analog ESC modes give a pulse width that is converted to a duty cycle at the channel frequency
+	switch(this->channelModes[channelIndex])
+	{
+		case PWM_MODE_ONESHOT125:
+			return (PWM_ONESHOT125_PULSE_MINIMUM + (PWM_ONESHOT125_PULSE_MAXIMUM - PWM_ONESHOT125_PULSE_MINIMUM) * .01 * percentage) * PWM_ONESHOT125_FREQUENCY_HZ * .0001;
+		case PWM_MODE_MULTISHOT:
+			return (PWM_MULTISHOT_PULSE_MINIMUM + (PWM_MULTISHOT_PULSE_MAXIMUM - PWM_MULTISHOT_PULSE_MINIMUM) * .01 * percentage) * PWM_MULTISHOT_FREQUENCY_HZ * .0001;
+		case PWM_MODE_SERVO:
+		default:
+			break;
+	}
+
+	//Channel ranges were measured at the default rate, scale them to keep the same pulse widths in faster groups
+	float rateScale = (float) this->groupFrequencies[this->channelGroups[channelIndex]] / PWM_DEFAULT_APPROX_FREQUENCY_HZ;
+
+	return ((this->channelMaximums[channelIndex] - this->channelMinimums[channelIndex]) * .01 * percentage + this->channelMinimums[channelIndex]) * rateScale;
+}
+
+pwm_state PWMHandler::setChannelOutputs(const float percentages[6], uint8_t channelMask)
+{
+	for(int i = 0; i < 6; i++)
+	{
+		if((channelMask & (1 << i)) && (percentages[i] < 0 || percentages[i] > 100))
+			return PWM_OUT_OF_RC_Range;
+	}
+
+	//Servo channels only record their duty here, each group chain is then written once from its first change
+	int chainStarts[PWM_GROUP_COUNT];
+	uint8_t groupsChanged = 0;
+
+	for(int i = 0; i < 6; i++)
+	{
+		if(!(channelMask & (1 << i)))
+			continue;
+
+		if(isDShotMode(this->channelModes[i]))
+		{
+			if(this->writeDShot(i, percentages[i]) != PWM_SUCCESS)
+				return PWM_FAILURE;
+
+			continue;
+		}
+
+		this->currentDutys[i] = this->outputDuty(i, percentages[i]);
+
+		if(this->prepareChannel(i, NULL) != PWM_SUCCESS)
+			return PWM_FAILURE;
+
+		if(this->channelModes[i] != PWM_MODE_SERVO)
+		{
+			if(FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_SET_DUTY, mcpwm_set_duty(this->unitChannelMap[i], (mcpwm_timer_t) (i%3), MCPWM_OPR_A, this->currentDutys[i])) != ESP_OK)
+				return PWM_FAILURE;
+		}
+		else if(!(groupsChanged & (1 << this->channelGroups[i])))
+		{
+			groupsChanged |= 1 << this->channelGroups[i];
+			chainStarts[this->channelGroups[i]] = i;
+		}
+	}
+
+	for(int group = 0; group < PWM_GROUP_COUNT; group++)
+	{
+		if((groupsChanged & (1 << group)) && this->applyGroupChain(chainStarts[group]) != PWM_SUCCESS)
+			return PWM_FAILURE;
+	}
+
+	return PWM_SUCCESS;
 }
 
 pwm_state PWMHandler::setChannelOutputAll(float channel1, float channel2, float channel3, float channel4, float channel5, float channel6)
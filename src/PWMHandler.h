@@ -24,9 +24,14 @@
 #define PWMHANDLER_H
 
 #include <driver/mcpwm.h>
+#include <driver/rmt.h>
+#include "DShotEncoder.h"
+#include "FlightChannels.h"
+#include "FlightClock.h"
 
 //Macros for PWM configurations for 6-channel mode based on experimental data
 #define PWM_DEFAULT_PERIOD_S .018302
+#define PWM_DEFAULT_PERIOD_US 18302
 #define PWM_DEFAULT_FREQUENCY_HZ 54.6388
 #define PWM_DEFAULT_APPROX_FREQUENCY_HZ 55
 
@@ -41,20 +46,30 @@
 #define PWM_DUTY_AUX_MINIMUM 5.43988
 #define PWM_DUTY_AUX_MAXIMUM 10.87071
 
-#define PWM_CHANNEL_AILERON 1
-#define PWM_CHANNEL_THROTTLE 2
-#define PWM_CHANNEL_ELEVATOR 3
-#define PWM_CHANNEL_RUDDER 4
-#define PWM_CHANNEL_AUX_A 5
-#define PWM_CHANNEL_AUX_B 6
+//Analog ESC output timing, pulse widths in microseconds
+#define PWM_ONESHOT125_FREQUENCY_HZ 2000
+#define PWM_ONESHOT125_PULSE_MINIMUM 125
+#define PWM_ONESHOT125_PULSE_MAXIMUM 250
+#define PWM_MULTISHOT_FREQUENCY_HZ 16000
+#define PWM_MULTISHOT_PULSE_MINIMUM 5
+#define PWM_MULTISHOT_PULSE_MAXIMUM 25
+
+//Number of independent channel groups, all channels start in group 0
+//Group 0 follows the external frame sync on PIN_A0, every other group is clocked by the timer of its first servo channel
+//and so must keep its channels on one MCPWM unit
+#define PWM_GROUP_COUNT 6
 
 /**
  * @brief Enumeration of MCPWM capable pins on the Adafruit ESP32 Feather
+ * @note A2, A3 and A4 are input only and can only be used for capture
  */
 typedef enum
 {
 	PIN_A0 = 26,
 	PIN_A1 = 25,
+	PIN_A2 = 34,
+	PIN_A3 = 39,
+	PIN_A4 = 36,
 	PIN_A5 = 4,
 	PIN_21 = 21,
 	PIN_13 = 13,
@@ -67,6 +82,42 @@ typedef enum
 } feather_pwm_capable_pins;
 
 
+/**
+ * @brief Output signal types for a channel
+ */
+typedef enum
+{
+	PWM_MODE_SERVO = 0,
+	PWM_MODE_ONESHOT125,
+	PWM_MODE_MULTISHOT,
+	PWM_MODE_DSHOT150,
+	PWM_MODE_DSHOT300,
+	PWM_MODE_DSHOT600
+} pwm_output_mode;
+
+
+/**
+ * @brief Time spent in each phase of PWMHandler::init, in microseconds
+ */
+typedef struct
+{
+	//Routing the sync input of each MCPWM unit
+	uint32_t syncMicros;
+
+	//Routing the channel output pins
+	uint32_t gpioMicros;
+
+	//Configuring the channel timers
+	uint32_t timerMicros;
+
+	//The whole call, the phase times above are summed over both cores when the units are brought up in parallel
+	uint32_t totalMicros;
+
+	//Number of MCPWM driver calls made
+	uint16_t driverCalls;
+} pwm_init_timing_t;
+
+
 /**
  * @brief PWM function return values
  */
@@ -75,7 +126,8 @@ typedef enum
 	PWM_SUCCESS = 0,
 	PWM_FAILURE,
 	PWM_INVALID_CHANNEL,
-	PWM_OUT_OF_RC_Range
+	PWM_OUT_OF_RC_Range,
+	PWM_RATE_TOO_HIGH
 } pwm_state;
 
 
@@ -112,6 +164,116 @@ protected:
 	//States whether or not init has been called
 	uint8_t initCalled = 0;
 
+	//States whether or not start has been called since the last stop
+	uint8_t running = 0;
+
+	//Bitmask of channels whose pin and timer have been configured
+	uint8_t channelsReady = 0;
+
+	//Bitmask of MCPWM units whose sync input has been configured
+	uint8_t unitsSynced = 0;
+
+	//States whether or not init brings up the second unit from a task on the other core
+	uint8_t parallelInit = 0;
+
+	//The output signal type of each channel
+	pwm_output_mode channelModes[6];
+
+	//The group each channel belongs to, servo channels in a group share a rate and a phase offset chain
+	uint8_t channelGroups[6];
+
+	//The servo frame rate of each group
+	uint32_t groupFrequencies[PWM_GROUP_COUNT];
+
+	//Frame encoders for channels in a DShot mode, null otherwise, owned by the handler
+	DShotEncoder * dshotEncoders[6];
+
+	//Boot phase timing of the last init call
+	pwm_init_timing_t initTiming;
+
+	//The source of time for init timing
+	FlightClock * clock;
+
+	/**
+	 * @brief Configure the pin and timer of a channel if that has not been done yet, starting the timer if the
+	 * outputs are running
+	 * 
+	 * @param channelIndex The zero based channel index
+	 * @param timing Where to accumulate phase timing, may be null
+	 * 
+	 * @return
+	 *     - PWM_SUCCESS The channel is ready
+	 *     - PWM_FAILURE MCPWMn failure
+	 */
+	pwm_state prepareChannel(int channelIndex, pwm_init_timing_t * timing);
+
+	/**
+	 * @brief Prepare every channel in a mask
+	 * 
+	 * @param channelMask Bit n set to prepare the channel with zero based index n
+	 * @param timing Where to accumulate phase timing, may be null
+	 * 
+	 * @return
+	 *     - PWM_SUCCESS Every channel is ready
+	 *     - PWM_FAILURE MCPWMn failure
+	 */
+	pwm_state prepareChannels(uint8_t channelMask, pwm_init_timing_t * timing);
+
+	/**
+	 * @brief Task body that prepares the channels of the second unit during a parallel init
+	 * 
+	 * @param arg The pwm_unit_init_t describing the work
+	 */
+	static void prepareUnitTask(void * arg);
+
+	/**
+	 * @brief Send a throttle percentage on a DShot channel, the RMT repeats the frame until the next change. While the
+	 * outputs are stopped the frame is only loaded into channel memory for start to play out
+	 * 
+	 * @param channelIndex The zero based channel index
+	 * @param percentage The throttle percentage
+	 * 
+	 * @return
+	 *     - PWM_SUCCESS The frame was queued
+	 *     - PWM_FAILURE RMT failure
+	 */
+	pwm_state writeDShot(int channelIndex, float percentage);
+
+	/**
+	 * @brief Convert an output percentage to the duty cycle of an MCPWM channel in its current mode and group
+	 * 
+	 * @param channelIndex The zero based index of a channel that is not in a DShot mode
+	 * @param percentage The output percentage, 0-100
+	 * 
+	 * @return The duty cycle percentage
+	 */
+	float outputDuty(int channelIndex, float percentage);
+
+	/**
+	 * @brief Rewrite the phase offsets and dutys of the servo channels in a channel's group, starting at that channel
+	 * 
+	 * @param channelIndex The zero based index of the first channel to rewrite
+	 * 
+	 * @return
+	 *     - PWM_SUCCESS Successful update
+	 *     - PWM_FAILURE MCPWMn failure
+	 */
+	pwm_state applyGroupChain(int channelIndex);
+
+	/**
+	 * @brief Check that the servo channels of a group fit in one frame at a rate, with every channel at its maximum
+	 * pulse width one after another along the phase offset chain
+	 * 
+	 * @param group The group to check
+	 * @param frequencyHz The rate to check at
+	 * @param channelIndex A zero based channel index to count as a servo channel of the group, -1 for none
+	 * 
+	 * @return
+	 *     - 1 the chain fits in the frame
+	 *     - 0 the chain would run past the end of the frame
+	 */
+	uint8_t groupChainFits(uint8_t group, uint32_t frequencyHz, int channelIndex);
+
 public:
 	/**
 	 * @brief Set specified PWM pins using a given MCPWM unit 
@@ -131,6 +293,15 @@ public:
 	 */
 	PWMHandler() : PWMHandler(MCPWM_UNIT_0, MCPWM_UNIT_1, PIN_12, PIN_27, PIN_33, PIN_15, PIN_32, PIN_14) {}
 
+	/**
+	 * @brief Stop and uninstall the RMT channels of DShot outputs and free their encoders
+	 */
+	~PWMHandler();
+
+	//The DShot encoders and RMT channels are owned, so a handler cannot be copied
+	PWMHandler(const PWMHandler &) = delete;
+	PWMHandler & operator=(const PWMHandler &) = delete;
+
 	/**
 	 * @brief Initialize the mcpwm unit and prepare for gpio output use
 	 * 
@@ -138,7 +309,55 @@ public:
 	 *     - PWM_SUCCESS Initialization successful
 	 *     - PWM_FAILURE MCPWMn failure
 	 */
-	pwm_state init();
+	pwm_state init() { return this->init(0x3F); }
+
+	/**
+	 * @brief Initialize only the given channels now, the rest are configured on their first duty change
+	 * 
+	 * @param channelMask Bit n-1 set to initialize channel n immediately
+	 * 
+	 * @return
+	 *     - PWM_SUCCESS Initialization successful
+	 *     - PWM_FAILURE MCPWMn failure
+	 */
+	pwm_state init(uint8_t channelMask);
+
+	/**
+	 * @brief Have init bring up the channels on the second MCPWM unit from a task pinned to the other core while the
+	 * calling core brings up the first unit
+	 * 
+	 * @param enabled 1 to initialize the units in parallel, 0 to initialize them one after the other
+	 * @note Ignored on single core targets and when both channel halves use the same unit
+	 */
+	void setParallelInit(uint8_t enabled) { this->parallelInit = enabled; }
+
+	/**
+	 * @brief State whether or not a channel has been configured and is producing its signal
+	 * 
+	 * @param channel The channel to check, 1-6
+	 * 
+	 * @return
+	 *     - 1 the channel was initialized, used, or is in a DShot mode
+	 *     - 0 the channel is deferred until its first duty change, or the channel number is invalid
+	 */
+	uint8_t isChannelReady(int channel)
+	{
+		return channel >= 1 && channel <= 6 && ((this->channelsReady & (1 << (channel - 1))) || this->dshotEncoders[channel - 1] != NULL);
+	}
+
+	/**
+	 * @brief Set the clock used to time init phases
+	 * 
+	 * @param clock The clock to use, the system clock is used if null
+	 */
+	void setClock(FlightClock * clock) { this->clock = clock != NULL ? clock : FlightClock::system(); }
+
+	/**
+	 * @brief Get the boot phase timing breakdown of the last init call
+	 * 
+	 * @return The phase timing
+	 */
+	pwm_init_timing_t getInitTiming() { return this->initTiming; }
 
 	/**
 	 * @brief State whether or not init has been called
@@ -150,7 +369,17 @@ public:
 	uint8_t isInitialized() { return this->initCalled; }
 
 	/**
-	 * @brief Activate all PWM outputs in current configuration
+	 * @brief Get the positive PWM duty cycle percentage last set on the given channel
+	 * 
+	 * @param channel The channel to read, 1-6
+	 * 
+	 * @return The duty cycle percentage, 0 for an invalid channel
+	 * @note DShot channels report where their last throttle value sits in the DShot throttle range, 0 when disarmed
+	 */
+	float getDuty(int channel) { return (channel < 1 || channel > 6) ? 0 : this->currentDutys[channel - 1]; }
+
+	/**
+	 * @brief Activate all PWM outputs in current configuration, DShot channels start looping the frame last loaded
 	 * 
 	 * @return
 	 *     - PWM_SUCCESS Successful start
@@ -159,7 +388,7 @@ public:
 	pwm_state start();
 
 	/**
-	 * @brief Deactivate all PWM outputs in current configuration
+	 * @brief Deactivate all PWM outputs in current configuration, DShot channels send a disarm frame and go quiet
 	 * 
 	 * @return
 	 *     - PWM_SUCCESS Successful stop
@@ -192,10 +421,74 @@ public:
 	 * @return
 	 *     - PWM_SUCCESS Successful duty change
 	 *     - PWM_FAILURE Duty change failed
-	 *     - PWM_INVALID_CHANNEL The given channel number is not 1-6, no change
+	 *     - PWM_INVALID_CHANNEL The given channel number is not 1-6 or is in a DShot mode, no change
 	 */
 	pwm_state setDuty(int channel, float dutyPercentage);
 
+	/**
+	 * @brief Change the output signal type of a channel, ESC modes run outside of the servo phase chain
+	 * @note DShot modes play frames out of RMT channel n-1 and take the pin away from the MCPWM timer
+	 * 
+	 * @param channel The channel to change
+	 * @param mode The signal type to output
+	 * 
+	 * @return
+	 *     - PWM_SUCCESS Successful mode change, a DShot channel starts out disarmed and only transmits while the
+	 *       outputs are running
+	 *     - PWM_FAILURE MCPWMn or RMT failure
+	 *     - PWM_INVALID_CHANNEL The given channel number is not 1-6, no change
+	 *     - PWM_RATE_TOO_HIGH A servo channel would not fit in a frame of its group, no change
+	 */
+	pwm_state setChannelMode(int channel, pwm_output_mode mode);
+
+	/**
+	 * @brief Move a channel into a group, it takes on the group rate and is chained only with that group's channels
+	 * 
+	 * @param channel The channel to move
+	 * @param group The group to move it to, 0 to PWM_GROUP_COUNT - 1
+	 * 
+	 * @return
+	 *     - PWM_SUCCESS Successful move
+	 *     - PWM_FAILURE MCPWMn failure
+	 *     - PWM_INVALID_CHANNEL The channel or group number is out of range, or the group already has channels on
+	 *       the other MCPWM unit, no change
+	 *     - PWM_RATE_TOO_HIGH A servo channel would not fit in a frame of the group, no change
+	 */
+	pwm_state setChannelGroup(int channel, uint8_t group);
+
+	/**
+	 * @brief Change the frame rate of every servo channel in a group, pulse widths are kept the same
+	 * 
+	 * @param group The group to change
+	 * @param frequencyHz The new frame rate
+	 * 
+	 * @return
+	 *     - PWM_SUCCESS Successful change
+	 *     - PWM_FAILURE MCPWMn failure
+	 *     - PWM_INVALID_CHANNEL The group number is out of range or the rate is 0, no change
+	 *     - PWM_RATE_TOO_HIGH The frame at this rate is shorter than the maximum pulses of the group's servo
+	 *       channels laid end to end, no change
+	 */
+	pwm_state setGroupFrequency(uint8_t group, uint32_t frequencyHz);
+
+	/**
+	 * @brief Get the frame rate of a group
+	 * 
+	 * @param group The group to read
+	 * 
+	 * @return The rate in Hz, 0 for an invalid group
+	 */
+	uint32_t getGroupFrequency(uint8_t group) { return group < PWM_GROUP_COUNT ? this->groupFrequencies[group] : 0; }
+
+	/**
+	 * @brief Get the output signal type of a channel
+	 * 
+	 * @param channel The channel to read, 1-6
+	 * 
+	 * @return The signal type, PWM_MODE_SERVO for an invalid channel
+	 */
+	pwm_output_mode getChannelMode(int channel) { return (channel < 1 || channel > 6) ? PWM_MODE_SERVO : this->channelModes[channel - 1]; }
+
 
 	/**
 	 * @brief Set the PWM duty cycle percentage of a channel to a percentage that defines where it should be in the
@@ -209,9 +502,24 @@ public:
 	 *     - PWM_FAILURE Duty change failed
 	 *     - PWM_INVALID_CHANNEL The given channel number is not 1-6, no change
 	 *     - PWM_OUT_OF_RC_RANGE The percentage value places duty cycle out of RC range, no change
+	 * @note ESC mode channels map the percentage onto their own pulse width or throttle value range
 	 */
 	pwm_state setChannelOutput(int channel, float percentage);
 
+	/**
+	 * @brief Set the output percentages of several channels at once, rewriting the phase chain of each servo group
+	 * once from its lowest changed channel rather than once per channel
+	 * 
+	 * @param percentages The output percentages of all six channels, in channel order
+	 * @param channelMask Bit n-1 set to change channel n, other channels are left as they are
+	 * 
+	 * @return
+	 *     - PWM_SUCCESS Successful duty change
+	 *     - PWM_FAILURE Duty change failed
+	 *     - PWM_OUT_OF_RC_RANGE The percentage for at least 1 changed channel is outside 0-100, no change
+	 */
+	pwm_state setChannelOutputs(const float percentages[6], uint8_t channelMask);
+
 
 	/**
 	 * @brief Set the PWM duty cycle percentage of all channel to percentages that define where they should be in the
@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "PulseDecoder.h"
+
+void PulseDecoder::reset()
+{
+	//Sequence lock writer, readers retry while the sequence is odd or changed during their copy
+	uint32_t sequence = this->sequence;
+	__atomic_store_n(&this->sequence, sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	this->riseTicks = 0;
+	this->risePending = 0;
+
+	this->stats.pulses = 0;
+	this->stats.glitches = 0;
+	this->stats.missedEdges = 0;
+	this->stats.lastWidth = 0;
+	this->stats.minimumWidth = 0xFFFF;
+	this->stats.maximumWidth = 0;
+	this->stats.lastPulseTime = 0;
+
+	__atomic_store_n(&this->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+void PulseDecoder::readStats(receiver_channel_stats_t & copy)
+{
+	//The edge handler only holds the lock for a few stores, so there is always a clean copy soon
+	while(1)
+	{
+		uint32_t before = __atomic_load_n(&this->sequence, __ATOMIC_ACQUIRE);
+		if(before & 1)
+			continue;
+
+		copy = this->stats;
+
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+		if(__atomic_load_n(&this->sequence, __ATOMIC_RELAXED) == before)
+			return;
+	}
+}
+
+uint16_t PulseDecoder::onEdge(uint8_t rising, uint32_t ticks, uint32_t nowMicros)
+{
+	uint16_t completed = 0;
+
+	uint32_t sequence = this->sequence;
+	__atomic_store_n(&this->sequence, sequence + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	if(rising)
+	{
+		if(this->risePending)
+			this->stats.missedEdges++;
+
+		this->riseTicks = ticks;
+		this->risePending = 1;
+	}
+	else if(this->risePending)
+	{
+		this->risePending = 0;
+
+		//Unsigned subtraction handles the capture timer wrapping between the edges
+		uint32_t width = (ticks - this->riseTicks) / RECEIVER_TICKS_PER_US;
+
+		if(width < RECEIVER_PULSE_MINIMUM || width > RECEIVER_PULSE_MAXIMUM)
+			this->stats.glitches++;
+		else
+		{
+			this->stats.pulses++;
+			this->stats.lastWidth = width;
+			this->stats.lastPulseTime = nowMicros;
+
+			if(width < this->stats.minimumWidth)
+				this->stats.minimumWidth = width;
+
+			if(width > this->stats.maximumWidth)
+				this->stats.maximumWidth = width;
+
+			completed = width;
+		}
+	}
+
+	__atomic_store_n(&this->sequence, sequence + 2, __ATOMIC_RELEASE);
+
+	return completed;
+}
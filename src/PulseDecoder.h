@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef PULSEDECODER_H
+#define PULSEDECODER_H
+
+#include <stdint.h>
+
+//MCPWM capture timer ticks per microsecond, the capture timer runs from the 80MHz APB clock
+#define RECEIVER_TICKS_PER_US 80
+
+//Pulse widths outside of this range are counted as glitches, in microseconds
+#define RECEIVER_PULSE_MINIMUM 800
+#define RECEIVER_PULSE_MAXIMUM 2200
+
+/**
+ * @brief Capture statistics of one receiver channel
+ */
+typedef struct
+{
+	//Pulses with a width inside the accepted range
+	uint32_t pulses;
+
+	//Pulses with a width outside the accepted range
+	uint32_t glitches;
+
+	//Rising edges seen without a falling edge since the last one
+	uint32_t missedEdges;
+
+	//Width of the last valid pulse, and the narrowest and widest seen, in microseconds
+	uint16_t lastWidth;
+	uint16_t minimumWidth;
+	uint16_t maximumWidth;
+
+	//Time of the last valid pulse in microseconds, low 32 bits of the system clock
+	uint32_t lastPulseTime;
+} receiver_channel_stats_t;
+
+/**
+ * @brief Turns a stream of capture edges on one channel into pulse widths using integer math only
+ */
+class PulseDecoder
+{
+protected:
+	//Capture tick count of the last rising edge
+	uint32_t riseTicks;
+
+	//States whether a rising edge is waiting for its falling edge
+	uint8_t risePending;
+
+	//Statistics, written by the edge handler
+	receiver_channel_stats_t stats;
+
+	//Sequence lock guarding stats, odd while an edge is being handled
+	uint32_t sequence;
+
+public:
+	PulseDecoder()
+	{
+		this->sequence = 0;
+		this->reset();
+	}
+
+	/**
+	 * @brief Clear the decoder state and statistics
+	 */
+	void reset();
+
+	/**
+	 * @brief Copy the statistics without tearing against an edge handled in an ISR at the same time
+	 * @note Waits out an edge in progress, so must not be called from an interrupt that can preempt onEdge
+	 * 
+	 * @param copy Where to copy the statistics
+	 */
+	void readStats(receiver_channel_stats_t & copy);
+
+	/**
+	 * @brief Handle one edge, safe to call from an ISR
+	 * 
+	 * @param rising 1 for a rising edge, 0 for a falling edge
+	 * @param ticks The capture timer value at the edge, may wrap
+	 * @param nowMicros The current time in microseconds
+	 * 
+	 * @return The width of the completed pulse in microseconds, or 0 if no valid pulse completed
+	 */
+	uint16_t onEdge(uint8_t rising, uint32_t ticks, uint32_t nowMicros);
+};
+
+#endif
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <Arduino.h>
+#include <soc/mcpwm_periph.h>
+#include "ReceiverCapture.h"
+#include "TraceRecorder.h"
+
+//Capture interrupt enable and status bit for capture signal n
+#define RECEIVER_CAPTURE_INTERRUPT(n) (1u << (27 + (n)))
+
+//Edge reported by mcpwm_capture_signal_get_edge for a rising edge
+#define RECEIVER_EDGE_RISING 1
+
+ReceiverCapture::ReceiverCapture(int channel1, int channel2, int channel3, int channel4, int channel5, int channel6)
+{
+	this->channelPins[0] = channel1;
+	this->channelPins[1] = channel2;
+	this->channelPins[2] = channel3;
+	this->channelPins[3] = channel4;
+	this->channelPins[4] = channel5;
+	this->channelPins[5] = channel6;
+
+	for(int i = 0; i < 6; i++)
+	{
+		this->channelModes[i] = RECEIVER_OFF;
+		this->blendWeights[i] = .5;
+		this->takeoverLatched[i] = 0;
+		this->takeoverReference[i] = -1;
+		this->channelLows[i] = RECEIVER_DEFAULT_LOW;
+		this->channelHighs[i] = RECEIVER_DEFAULT_HIGH;
+	}
+
+	this->clock = FlightClock::system();
+}
+
+pwm_state ReceiverCapture::init()
+{
+	static const mcpwm_io_signals_t captureInputs[3] = { MCPWM_CAP_0, MCPWM_CAP_1, MCPWM_CAP_2 };
+	static const mcpwm_capture_signal_t captureSignals[3] = { MCPWM_SELECT_CAP0, MCPWM_SELECT_CAP1, MCPWM_SELECT_CAP2 };
+
+	for(int i = 0; i < 6; i++)
+	{
+		mcpwm_unit_t unit = i < 3 ? MCPWM_UNIT_0 : MCPWM_UNIT_1;
+
+		if(FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_GPIO_INIT, mcpwm_gpio_init(unit, captureInputs[i % 3], this->channelPins[i])) != ESP_OK)
+			return PWM_FAILURE;
+
+		if(FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_CAPTURE_ENABLE, mcpwm_capture_enable(unit, captureSignals[i % 3], MCPWM_BOTH_EDGE, 0)) != ESP_OK)
+			return PWM_FAILURE;
+	}
+
+	MCPWM0.int_ena.val |= RECEIVER_CAPTURE_INTERRUPT(0) | RECEIVER_CAPTURE_INTERRUPT(1) | RECEIVER_CAPTURE_INTERRUPT(2);
+	MCPWM1.int_ena.val |= RECEIVER_CAPTURE_INTERRUPT(0) | RECEIVER_CAPTURE_INTERRUPT(1) | RECEIVER_CAPTURE_INTERRUPT(2);
+
+	//Not an IRAM interrupt, the handler reads the capture through the MCPWM driver and the clock, both in flash
+	if(FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_ISR_REGISTER, mcpwm_isr_register(MCPWM_UNIT_0, ReceiverCapture::captureISR, this, 0, NULL)) != ESP_OK)
+		return PWM_FAILURE;
+
+	if(FCE_TRACE_CALL(TRACE_MCPWM_CALL, TRACE_MCPWM_ISR_REGISTER, mcpwm_isr_register(MCPWM_UNIT_1, ReceiverCapture::captureISR, this, 0, NULL)) != ESP_OK)
+		return PWM_FAILURE;
+
+	return PWM_SUCCESS;
+}
+
+void ReceiverCapture::captureISR(void * arg)
+{
+	ReceiverCapture * capture = (ReceiverCapture *) arg;
+
+	capture->handleUnit(0);
+	capture->handleUnit(1);
+}
+
+void ReceiverCapture::handleUnit(int unitIndex)
+{
+	mcpwm_dev_t * device = unitIndex == 0 ? &MCPWM0 : &MCPWM1;
+	mcpwm_unit_t unit = unitIndex == 0 ? MCPWM_UNIT_0 : MCPWM_UNIT_1;
+
+	uint32_t status = device->int_st.val;
+
+	uint32_t now = (uint32_t) this->clock->now();
+
+	for(int i = 0; i < 3; i++)
+	{
+		if(!(status & RECEIVER_CAPTURE_INTERRUPT(i)))
+			continue;
+
+		mcpwm_capture_signal_t signal = (mcpwm_capture_signal_t) (MCPWM_SELECT_CAP0 + i);
+		uint32_t ticks = mcpwm_capture_signal_get_value(unit, signal);
+		uint8_t rising = mcpwm_capture_signal_get_edge(unit, signal) == RECEIVER_EDGE_RISING;
+
+		this->decoders[unitIndex * 3 + i].onEdge(rising, ticks, now);
+	}
+
+	device->int_clr.val = status & (RECEIVER_CAPTURE_INTERRUPT(0) | RECEIVER_CAPTURE_INTERRUPT(1) | RECEIVER_CAPTURE_INTERRUPT(2));
+}
+
+pwm_state ReceiverCapture::setChannelMode(int channel, receiver_mode mode, float weight)
+{
+	if(channel < 1 || channel > 6 || weight < 0 || weight > 1)
+		return PWM_INVALID_CHANNEL;
+
+	this->channelModes[channel - 1] = mode;
+	this->blendWeights[channel - 1] = weight;
+	this->takeoverLatched[channel - 1] = 0;
+	this->takeoverReference[channel - 1] = -1;
+
+	return PWM_SUCCESS;
+}
+
+pwm_state ReceiverCapture::setChannelRange(int channel, uint16_t lowWidth, uint16_t highWidth)
+{
+	if(channel < 1 || channel > 6 || lowWidth >= highWidth)
+		return PWM_INVALID_CHANNEL;
+
+	this->channelLows[channel - 1] = lowWidth;
+	this->channelHighs[channel - 1] = highWidth;
+
+	return PWM_SUCCESS;
+}
+
+uint8_t ReceiverCapture::getValue(int channel, float & percentage)
+{
+	if(channel < 1 || channel > 6)
+		return 0;
+
+	channel --;
+
+	//The width and time have to come from the same pulse
+	receiver_channel_stats_t stats;
+	this->decoders[channel].readStats(stats);
+
+	uint16_t width = stats.lastWidth;
+
+	if(stats.pulses == 0 || (uint32_t) this->clock->now() - stats.lastPulseTime > RECEIVER_SIGNAL_TIMEOUT)
+		return 0;
+
+	if(width <= this->channelLows[channel])
+		percentage = 0;
+	else if(width >= this->channelHighs[channel])
+		percentage = 100;
+	else
+		percentage = (width - this->channelLows[channel]) * 100.f / (this->channelHighs[channel] - this->channelLows[channel]);
+
+	return 1;
+}
+
+float ReceiverCapture::mix(int channel, float emulated)
+{
+	float received;
+
+	if(channel < 1 || channel > 6 || this->channelModes[channel - 1] == RECEIVER_OFF)
+		return emulated;
+
+	channel --;
+
+	if(!this->getValue(channel + 1, received))
+	{
+		//A pilot who lost signal has to take over again from wherever the stick rests once it is back
+		this->takeoverLatched[channel] = 0;
+		this->takeoverReference[channel] = -1;
+		return emulated;
+	}
+
+	switch(this->channelModes[channel])
+	{
+		case RECEIVER_PASSTHROUGH:
+			return received;
+
+		case RECEIVER_BLEND:
+			return received * this->blendWeights[channel] + emulated * (1 - this->blendWeights[channel]);
+
+		case RECEIVER_TAKEOVER:
+			//The stick hands over when it moves from where it rested, so a throttle sitting at 0% does not
+			if(this->takeoverReference[channel] < 0)
+				this->takeoverReference[channel] = received;
+			else if(received > this->takeoverReference[channel] + RECEIVER_TAKEOVER_DEADBAND ||
+				received < this->takeoverReference[channel] - RECEIVER_TAKEOVER_DEADBAND)
+				this->takeoverLatched[channel] = 1;
+
+			return this->takeoverLatched[channel] ? received : emulated;
+
+		case RECEIVER_OFF:
+		default:
+			return emulated;
+	}
+}
+
+uint8_t ReceiverCapture::isActive(int channel)
+{
+	float received;
+
+	if(channel < 1 || channel > 6 || this->channelModes[channel - 1] == RECEIVER_OFF || !this->getValue(channel, received))
+		return 0;
+
+	return this->channelModes[channel - 1] != RECEIVER_TAKEOVER || this->takeoverLatched[channel - 1];
+}
+
+uint8_t ReceiverCapture::isTracking(int channel)
+{
+	float received;
+
+	if(channel < 1 || channel > 6 || this->channelModes[channel - 1] == RECEIVER_OFF)
+		return 0;
+
+	//A latched takeover is mixed until mix sees its signal go and hands it back
+	return this->getValue(channel, received) || this->takeoverLatched[channel - 1];
+}
+
+void ReceiverCapture::releaseTakeover()
+{
+	for(int i = 0; i < 6; i++)
+	{
+		this->takeoverLatched[i] = 0;
+		this->takeoverReference[i] = -1;
+	}
+}
+
+receiver_channel_stats_t ReceiverCapture::getStats(int channel)
+{
+	receiver_channel_stats_t stats = receiver_channel_stats_t();
+
+	if(channel >= 1 && channel <= 6)
+		this->decoders[channel - 1].readStats(stats);
+
+	return stats;
+}
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef RECEIVERCAPTURE_H
+#define RECEIVERCAPTURE_H
+
+#include "PWMHandler.h"
+#include "PulseDecoder.h"
+
+//Default pulse widths for 0% and 100% output, in microseconds
+#define RECEIVER_DEFAULT_LOW 1000
+#define RECEIVER_DEFAULT_HIGH 2000
+
+//A channel with no valid pulse for this long has lost signal, in microseconds
+#define RECEIVER_SIGNAL_TIMEOUT 100000
+
+//Distance, in percent, that a takeover channel's stick has to move from where it rested to hand control to the pilot
+#define RECEIVER_TAKEOVER_DEADBAND 5
+
+/**
+ * @brief How a receiver channel is combined with the emulated value for that channel
+ */
+typedef enum
+{
+	//Only the emulated value is output
+	RECEIVER_OFF = 0,
+
+	//The receiver value is output while it has signal
+	RECEIVER_PASSTHROUGH,
+
+	//A weighted mix of the receiver and emulated values is output while the receiver has signal
+	RECEIVER_BLEND,
+
+	//The emulated value is output until the pilot moves the stick away from where it first rested, then the receiver
+	//value until released or the signal is lost
+	RECEIVER_TAKEOVER
+} receiver_mode;
+
+/**
+ * @brief Captures the six PWM channels of an RC receiver with the MCPWM capture units, so a pilot can be
+ * mixed with or take over from emulated commands
+ * @note The capture units share the MCPWM peripherals with PWMHandler, unit 0 captures channels 1-3 and
+ * unit 1 channels 4-6
+ */
+class ReceiverCapture
+{
+protected:
+	//Map of channels to capture input pins
+	int channelPins[6];
+
+	//Edge decoders for each channel
+	PulseDecoder decoders[6];
+
+	//Combination settings for each channel
+	receiver_mode channelModes[6];
+	float blendWeights[6];
+	uint8_t takeoverLatched[6];
+
+	//Stick position of each takeover channel at its first valid pulse since the mode was set or control was handed
+	//back, negative until then
+	float takeoverReference[6];
+
+	//Pulse widths for 0% and 100% output on each channel
+	uint16_t channelLows[6];
+	uint16_t channelHighs[6];
+
+	//The source of time for pulse timestamps and signal loss
+	FlightClock * clock;
+
+	/**
+	 * @brief Capture interrupt handler for one MCPWM unit
+	 * 
+	 * @param arg The ReceiverCapture instance
+	 */
+	static void captureISR(void * arg);
+
+	/**
+	 * @brief Handle the capture interrupts pending on a unit
+	 */
+	void handleUnit(int unitIndex);
+
+public:
+	/**
+	 * @brief Set capture pins for the six receiver channels
+	 */
+	ReceiverCapture(int channel1, int channel2, int channel3, int channel4, int channel5, int channel6);
+
+	/**
+	 * @brief Use the default Feather capture pins
+	 */
+	ReceiverCapture() : ReceiverCapture(PIN_A1, PIN_A5, PIN_21, PIN_13, PIN_A2, PIN_A3) {}
+
+	/**
+	 * @brief Route the capture pins and start capturing both edges on all channels
+	 * 
+	 * @return
+	 *     - PWM_SUCCESS Capture started
+	 *     - PWM_FAILURE MCPWMn failure
+	 */
+	pwm_state init();
+
+	/**
+	 * @brief Set the clock used to timestamp pulses and detect signal loss
+	 * 
+	 * @param clock The clock to use, the system clock is used if null
+	 */
+	void setClock(FlightClock * clock) { this->clock = clock != NULL ? clock : FlightClock::system(); }
+
+	/**
+	 * @brief Set how a channel is combined with its emulated value
+	 * 
+	 * @param channel The channel, 1-6
+	 * @param mode The combination mode
+	 * @param weight For RECEIVER_BLEND, the share of the receiver value from 0 to 1
+	 * 
+	 * @return
+	 *     - PWM_SUCCESS Mode set
+	 *     - PWM_INVALID_CHANNEL The channel number is not 1-6 or the weight is out of range, no change
+	 */
+	pwm_state setChannelMode(int channel, receiver_mode mode, float weight);
+
+	pwm_state setChannelMode(int channel, receiver_mode mode) { return this->setChannelMode(channel, mode, .5); }
+
+	/**
+	 * @brief Set the pulse widths that correspond to 0% and 100% on a channel
+	 * 
+	 * @param channel The channel, 1-6
+	 * @param lowWidth The 0% pulse width in microseconds
+	 * @param highWidth The 100% pulse width in microseconds
+	 * 
+	 * @return
+	 *     - PWM_SUCCESS Range set
+	 *     - PWM_INVALID_CHANNEL The channel number is not 1-6 or the range is empty, no change
+	 */
+	pwm_state setChannelRange(int channel, uint16_t lowWidth, uint16_t highWidth);
+
+	/**
+	 * @brief Get the last valid receiver value of a channel
+	 * 
+	 * @param channel The channel, 1-6
+	 * @param percentage Where to write the value as a percentage
+	 * 
+	 * @return
+	 *     - 1 the channel has signal
+	 *     - 0 the channel is invalid or has lost signal
+	 */
+	uint8_t getValue(int channel, float & percentage);
+
+	/**
+	 * @brief Combine the receiver value of a channel with its emulated value according to the channel mode
+	 * 
+	 * @param channel The channel, 1-6
+	 * @param emulated The emulated value as a percentage
+	 * 
+	 * @return The value to output as a percentage
+	 */
+	float mix(int channel, float emulated);
+
+	/**
+	 * @brief Check whether a channel is currently controlled by the receiver rather than emulated commands
+	 * 
+	 * @param channel The channel, 1-6
+	 * 
+	 * @return
+	 *     - 1 the receiver contributes to the output
+	 *     - 0 only the emulated value is output
+	 */
+	uint8_t isActive(int channel);
+
+	/**
+	 * @brief Check whether mix has to see a channel every frame, because the receiver contributes to it or a takeover
+	 * channel is watching its stick
+	 * 
+	 * @param channel The channel, 1-6
+	 * 
+	 * @return
+	 *     - 1 the channel has to be mixed every frame
+	 *     - 0 only the emulated value is output and mixing can wait for the next emulated change
+	 */
+	uint8_t isTracking(int channel);
+
+	/**
+	 * @brief Return every takeover channel to emulated control, the stick position it rests at next becomes the new
+	 * reference
+	 */
+	void releaseTakeover();
+
+	/**
+	 * @brief Copy the capture statistics of a channel
+	 * 
+	 * @param channel The channel, 1-6
+	 * 
+	 * @return The statistics, all zero for an invalid channel
+	 */
+	receiver_channel_stats_t getStats(int channel);
+};
+
+#endif
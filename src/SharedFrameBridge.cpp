@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "SharedFrameBridge.h"
+
+#if defined(__unix__) && !defined(ESP_PLATFORM)
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+shared_frame_state SharedFrameBridge::open()
+{
+	if(this->region != NULL)
+		return SHARED_FRAME_SUCCESS;
+
+	int fd = shm_open(this->name, O_RDWR | O_CREAT, 0644);
+	if(fd < 0)
+		return SHARED_FRAME_FAILURE;
+
+	if(ftruncate(fd, sizeof(shared_frame_region_t)) != 0)
+	{
+		::close(fd);
+		return SHARED_FRAME_FAILURE;
+	}
+
+	void * mapping = mmap(NULL, sizeof(shared_frame_region_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);
+
+	if(mapping == MAP_FAILED)
+		return SHARED_FRAME_FAILURE;
+
+	this->region = (shared_frame_region_t *) mapping;
+
+	//Keep publishing into a compatible ring so readers already attached to it carry on
+	if(__atomic_load_n(&this->region->magic, __ATOMIC_ACQUIRE) == SHARED_FRAME_MAGIC && this->region->version == SHARED_FRAME_VERSION &&
+		this->region->slotCount == SHARED_FRAME_SLOTS)
+		return SHARED_FRAME_SUCCESS;
+
+	//A new or incompatible object, no compatible reader can be attached so it is safe to clear
+	__atomic_store_n(&this->region->magic, 0, __ATOMIC_RELEASE);
+	memset((void *) this->region, 0, sizeof(shared_frame_region_t));
+	this->region->version = SHARED_FRAME_VERSION;
+	this->region->slotCount = SHARED_FRAME_SLOTS;
+	__atomic_store_n(&this->region->magic, SHARED_FRAME_MAGIC, __ATOMIC_RELEASE);
+
+	return SHARED_FRAME_SUCCESS;
+}
+
+void SharedFrameBridge::close()
+{
+	if(this->region == NULL)
+		return;
+
+	munmap(this->region, sizeof(shared_frame_region_t));
+	this->region = NULL;
+}
+
+void SharedFrameBridge::remove()
+{
+	this->close();
+	shm_unlink(this->name);
+}
+
+void SharedFrameBridge::onFrameCommit(const FlightFrame & frame)
+{
+	if(this->region == NULL)
+		return;
+
+	uint64_t head = this->region->head;
+	shared_frame_slot_t * slot = &this->region->slots[head % SHARED_FRAME_SLOTS];
+
+	uint32_t lock = slot->lock;
+	__atomic_store_n(&slot->lock, lock + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	slot->sequence = frame.sequence;
+	slot->index = head;
+	slot->timestamp = frame.timestamp;
+	for(int i = 0; i < 6; i++)
+	{
+		slot->values[i] = frame.values[i];
+		slot->dutys[i] = frame.dutys[i];
+	}
+
+	__atomic_store_n(&slot->lock, lock + 2, __ATOMIC_RELEASE);
+	__atomic_store_n(&this->region->head, head + 1, __ATOMIC_RELEASE);
+}
+
+#else
+
+shared_frame_state SharedFrameBridge::open()
+{
+	return SHARED_FRAME_FAILURE;
+}
+
+void SharedFrameBridge::close()
+{
+}
+
+void SharedFrameBridge::remove()
+{
+}
+
+void SharedFrameBridge::onFrameCommit(const FlightFrame & frame)
+{
+	(void) frame;
+}
+
+#endif
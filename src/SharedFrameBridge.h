@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SHAREDFRAMEBRIDGE_H
+#define SHAREDFRAMEBRIDGE_H
+
+#include <stddef.h>
+#include "FlightFrame.h"
+#include "SharedFrameRing.h"
+
+/**
+ * @brief SharedFrameBridge function return values
+ */
+typedef enum
+{
+	SHARED_FRAME_SUCCESS = 0,
+	SHARED_FRAME_FAILURE
+} shared_frame_state;
+
+/**
+ * @brief Publishes committed frames into a POSIX shared memory ring for host side simulators,
+ * see SharedFrameRing.h for the reader API
+ * @note Only available on POSIX hosts, open() fails everywhere else
+ */
+class SharedFrameBridge : public FlightFrameListener
+{
+protected:
+	//Name of the shared memory object
+	const char * name;
+
+	//The mapped ring, null when closed
+	shared_frame_region_t * region;
+
+public:
+	/**
+	 * @brief Prepare a bridge using the given shared memory object name
+	 * 
+	 * @param name The object name, must start with a slash
+	 */
+	SharedFrameBridge(const char * name) : name(name), region(NULL) {}
+
+	/**
+	 * @brief Prepare a bridge using SHARED_FRAME_DEFAULT_NAME
+	 */
+	SharedFrameBridge() : SharedFrameBridge(SHARED_FRAME_DEFAULT_NAME) {}
+
+	~SharedFrameBridge() { this->close(); }
+
+	/**
+	 * @brief Create and map the shared memory object, a ring left by an earlier bridge with the same layout is
+	 * carried on from its last frame so attached readers keep reading
+	 * 
+	 * @return
+	 *     - SHARED_FRAME_SUCCESS the ring is ready for frames
+	 *     - SHARED_FRAME_FAILURE the object could not be created or mapped
+	 */
+	shared_frame_state open();
+
+	/**
+	 * @brief Unmap the shared memory object, leaving it in place for readers and the next open
+	 */
+	void close();
+
+	/**
+	 * @brief Unmap and unlink the shared memory object, readers still mapping it see no further frames
+	 */
+	void remove();
+
+	/**
+	 * @brief Write a frame into the next ring slot
+	 * 
+	 * @param frame The frame to publish
+	 */
+	void onFrameCommit(const FlightFrame & frame);
+};
+
+#endif
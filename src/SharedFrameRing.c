@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#if defined(__unix__) && !defined(ESP_PLATFORM)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "SharedFrameRing.h"
+
+int shared_frame_reader_open(shared_frame_reader_t * reader, const char * name)
+{
+	reader->region = 0;
+	reader->nextIndex = 0;
+	reader->overruns = 0;
+
+	int fd = shm_open(name ? name : SHARED_FRAME_DEFAULT_NAME, O_RDONLY, 0);
+	if(fd < 0)
+		return -1;
+
+	void * mapping = mmap(0, sizeof(shared_frame_region_t), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if(mapping == MAP_FAILED)
+		return -1;
+
+	const shared_frame_region_t * region = (const shared_frame_region_t *) mapping;
+	if(region->magic != SHARED_FRAME_MAGIC || region->version != SHARED_FRAME_VERSION || region->slotCount != SHARED_FRAME_SLOTS)
+	{
+		munmap(mapping, sizeof(shared_frame_region_t));
+		return -1;
+	}
+
+	reader->region = region;
+	reader->nextIndex = __atomic_load_n(&region->head, __ATOMIC_ACQUIRE);
+	return 0;
+}
+
+void shared_frame_reader_close(shared_frame_reader_t * reader)
+{
+	if(reader->region)
+		munmap((void *) reader->region, sizeof(shared_frame_region_t));
+
+	reader->region = 0;
+}
+
+#endif
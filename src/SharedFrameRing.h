@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef SHAREDFRAMERING_H
+#define SHAREDFRAMERING_H
+
+/*
+ * Layout and reader API for the shared memory ring that SharedFrameBridge publishes committed frames into.
+ * This header is plain C so that external simulators can read frames without linking the rest of the library.
+ * Each slot is guarded by its own sequence lock, readers never make system calls or block the writer.
+ */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define SHARED_FRAME_MAGIC 0x46434546
+#define SHARED_FRAME_VERSION 2
+#define SHARED_FRAME_SLOTS 64
+#define SHARED_FRAME_DEFAULT_NAME "/flight_control_emulator"
+
+/**
+ * @brief One frame in the ring, padded to two cache lines
+ */
+typedef struct
+{
+	//Sequence lock, odd while the writer is updating the slot
+	uint32_t lock;
+
+	//The emulator frame sequence number
+	uint32_t sequence;
+
+	//Publish count of the frame held in the slot, lets a reader tell its frame from one written a lap later
+	uint64_t index;
+
+	//Clock time of the commit in microseconds
+	uint64_t timestamp;
+
+	//The output percentages for all channels
+	float values[6];
+
+	//The protocol duty cycle percentages for all channels
+	float dutys[6];
+} __attribute__((aligned(64))) shared_frame_slot_t;
+
+/**
+ * @brief The full shared memory region
+ */
+typedef struct
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t slotCount;
+	uint32_t reserved;
+
+	//Total number of frames ever published, the newest frame is in slot (head - 1) % slotCount
+	uint64_t head;
+
+	shared_frame_slot_t slots[SHARED_FRAME_SLOTS];
+} __attribute__((aligned(64))) shared_frame_region_t;
+
+/**
+ * @brief A frame copied out of the ring
+ */
+typedef struct
+{
+	uint32_t sequence;
+	uint64_t index;
+	uint64_t timestamp;
+	float values[6];
+	float dutys[6];
+} shared_frame_t;
+
+/**
+ * @brief Reader handle, one per reading thread
+ */
+typedef struct
+{
+	//The mapped region, null if not open
+	const shared_frame_region_t * region;
+
+	//The publish count of the next frame to be returned by shared_frame_reader_next
+	uint64_t nextIndex;
+
+	//Number of frames overwritten before this reader could see them
+	uint64_t overruns;
+} shared_frame_reader_t;
+
+/**
+ * @brief Map an existing ring read only
+ * 
+ * @param reader The reader to initialize
+ * @param name The shared memory object name, SHARED_FRAME_DEFAULT_NAME if null
+ * 
+ * @return
+ *     - 0 the ring was mapped
+ *     - -1 the ring does not exist or has an incompatible layout
+ */
+int shared_frame_reader_open(shared_frame_reader_t * reader, const char * name);
+
+/**
+ * @brief Unmap the ring
+ * 
+ * @param reader The reader to close
+ */
+void shared_frame_reader_close(shared_frame_reader_t * reader);
+
+/**
+ * @brief Copy a slot out of the ring without tearing
+ * 
+ * @return
+ *     - 1 the copy is consistent
+ *     - 0 the writer touched the slot during the copy
+ */
+static inline int shared_frame_read_slot(const shared_frame_slot_t * slot, shared_frame_t * frame)
+{
+	uint32_t before = __atomic_load_n(&slot->lock, __ATOMIC_ACQUIRE);
+	if(before & 1)
+		return 0;
+
+	frame->sequence = slot->sequence;
+	frame->index = slot->index;
+	frame->timestamp = slot->timestamp;
+	for(int i = 0; i < 6; i++)
+	{
+		frame->values[i] = slot->values[i];
+		frame->dutys[i] = slot->dutys[i];
+	}
+
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	return __atomic_load_n(&slot->lock, __ATOMIC_RELAXED) == before;
+}
+
+/**
+ * @brief Get the most recently published frame
+ * 
+ * @param reader An open reader
+ * @param frame Where to copy the frame
+ * 
+ * @return
+ *     - 1 a frame was copied
+ *     - 0 nothing has been published yet
+ */
+static inline int shared_frame_reader_latest(shared_frame_reader_t * reader, shared_frame_t * frame)
+{
+	for(;;)
+	{
+		uint64_t head = __atomic_load_n(&reader->region->head, __ATOMIC_ACQUIRE);
+		if(head == 0)
+			return 0;
+
+		if(shared_frame_read_slot(&reader->region->slots[(head - 1) % SHARED_FRAME_SLOTS], frame))
+			return 1;
+	}
+}
+
+/**
+ * @brief Get the next frame in publish order, skipping ahead and counting overruns if the writer lapped this reader
+ * 
+ * @param reader An open reader
+ * @param frame Where to copy the frame
+ * 
+ * @return
+ *     - 1 a frame was copied
+ *     - 0 no new frame has been published
+ */
+static inline int shared_frame_reader_next(shared_frame_reader_t * reader, shared_frame_t * frame)
+{
+	for(;;)
+	{
+		uint64_t head = __atomic_load_n(&reader->region->head, __ATOMIC_ACQUIRE);
+
+		//The ring was recreated under this reader, pick up from its current end
+		if(reader->nextIndex > head)
+			reader->nextIndex = head;
+
+		if(reader->nextIndex == head)
+			return 0;
+
+		if(head - reader->nextIndex > SHARED_FRAME_SLOTS - 1)
+		{
+			reader->overruns += head - reader->nextIndex - (SHARED_FRAME_SLOTS - 1);
+			reader->nextIndex = head - (SHARED_FRAME_SLOTS - 1);
+		}
+
+		if(!shared_frame_read_slot(&reader->region->slots[reader->nextIndex % SHARED_FRAME_SLOTS], frame))
+			continue;
+
+		//The writer lapped this reader between reading head and copying the slot, skip to half a ring behind
+		//the writer so the next copy is not racing the slot about to be overwritten
+		if(frame->index != reader->nextIndex)
+		{
+			head = __atomic_load_n(&reader->region->head, __ATOMIC_ACQUIRE);
+			reader->overruns += head - SHARED_FRAME_SLOTS / 2 - reader->nextIndex;
+			reader->nextIndex = head - SHARED_FRAME_SLOTS / 2;
+			continue;
+		}
+
+		reader->nextIndex++;
+		return 1;
+	}
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <freertos/FreeRTOS.h>
+#include "TraceRecorder.h"
+
+#ifdef FCE_TRACE_ENABLED
+
+static trace_event_t traceRing[FCE_TRACE_RING_SIZE];
+
+//Index + 1 of the event last written completely to each slot, 0 while a write is in progress, so a dump can tell a
+//finished event from one a writer that got past the pause check is still filling in
+static uint32_t traceCommitted[FCE_TRACE_RING_SIZE];
+
+//Total number of events ever recorded, the next event goes in slot traceHead % FCE_TRACE_RING_SIZE
+static uint32_t traceHead = 0;
+
+static uint8_t tracePaused = 0;
+
+//The clock events are stamped with, the system clock until one is set
+static FlightClock * traceClock = NULL;
+
+void TraceRecorder::record(trace_event_type type, trace_phase phase, uint16_t arg, uint32_t value)
+{
+	if(__atomic_load_n(&tracePaused, __ATOMIC_RELAXED))
+		return;
+
+	uint32_t index = __atomic_fetch_add(&traceHead, 1, __ATOMIC_RELAXED);
+	uint32_t slot = index & (FCE_TRACE_RING_SIZE - 1);
+
+	__atomic_store_n(&traceCommitted[slot], 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	traceRing[slot].timestamp = (uint32_t) (traceClock != NULL ? traceClock : FlightClock::system())->now();
+	traceRing[slot].type = type;
+	traceRing[slot].phase = phase;
+	traceRing[slot].arg = arg;
+	traceRing[slot].core = (uint8_t) xPortGetCoreID();
+	traceRing[slot].value = value;
+
+	__atomic_store_n(&traceCommitted[slot], index + 1, __ATOMIC_RELEASE);
+}
+
+void TraceRecorder::dump(void (*writeLine)(const char * line))
+{
+	__atomic_store_n(&tracePaused, 1, __ATOMIC_RELAXED);
+
+	uint32_t head = __atomic_load_n(&traceHead, __ATOMIC_ACQUIRE);
+	uint32_t count = head < FCE_TRACE_RING_SIZE ? head : FCE_TRACE_RING_SIZE;
+	char line[48];
+
+	snprintf(line, sizeof(line), "TRACE BEGIN %lu", (unsigned long) count);
+	writeLine(line);
+
+	for(uint32_t i = head - count; i != head; i++)
+	{
+		uint32_t slot = i & (FCE_TRACE_RING_SIZE - 1);
+
+		//Copy the event between two reads of its commit mark, skipping it unless both show this event finished
+		if(__atomic_load_n(&traceCommitted[slot], __ATOMIC_ACQUIRE) != i + 1)
+			continue;
+
+		trace_event_t event = traceRing[slot];
+		__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+		if(__atomic_load_n(&traceCommitted[slot], __ATOMIC_RELAXED) != i + 1)
+			continue;
+
+		snprintf(line, sizeof(line), "T %lu %u %c %u %lu %u", (unsigned long) event.timestamp, event.type, event.phase, event.arg,
+			(unsigned long) event.value, event.core);
+		writeLine(line);
+	}
+
+	writeLine("TRACE END");
+
+	__atomic_store_n(&tracePaused, 0, __ATOMIC_RELAXED);
+}
+
+void TraceRecorder::clear()
+{
+	//Marks left by the old events would match the new indices
+	for(uint32_t i = 0; i < FCE_TRACE_RING_SIZE; i++)
+		__atomic_store_n(&traceCommitted[i], 0, __ATOMIC_RELAXED);
+
+	__atomic_store_n(&traceHead, 0, __ATOMIC_RELEASE);
+}
+
+void TraceRecorder::setClock(FlightClock * clock)
+{
+	traceClock = clock;
+}
+
+#else
+
+void TraceRecorder::record(trace_event_type type, trace_phase phase, uint16_t arg, uint32_t value)
+{
+	(void) type;
+	(void) phase;
+	(void) arg;
+	(void) value;
+}
+
+void TraceRecorder::dump(void (*writeLine)(const char * line))
+{
+	writeLine("TRACE BEGIN 0");
+	writeLine("TRACE END");
+}
+
+void TraceRecorder::clear()
+{
+}
+
+void TraceRecorder::setClock(FlightClock * clock)
+{
+	(void) clock;
+}
+
+#endif
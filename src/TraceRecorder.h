@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+#include <stdint.h>
+#include "FlightClock.h"
+
+/*
+ * Trace events are only recorded when the library is built with FCE_TRACE_ENABLED defined, for example with
+ * build_flags = -DFCE_TRACE_ENABLED in platformio.ini. Otherwise the FCE_TRACE_* macros compile to nothing,
+ * or to the bare expression for FCE_TRACE_CALL, and the ring takes no memory.
+ */
+
+//Number of events kept, must be a power of two
+#ifndef FCE_TRACE_RING_SIZE
+#define FCE_TRACE_RING_SIZE 1024
+#endif
+
+/**
+ * @brief What a trace event marks
+ */
+typedef enum
+{
+	TRACE_BYTE_RX = 0,
+	TRACE_COMMAND_PARSE,
+	TRACE_EMULATOR_CALL,
+	TRACE_SET_DUTY,
+	TRACE_MCPWM_CALL,
+	TRACE_FRAME_COMMIT
+} trace_event_type;
+
+/**
+ * @brief Which function a TRACE_EMULATOR_CALL or TRACE_MCPWM_CALL event is for
+ */
+typedef enum
+{
+	TRACE_CALL_IDLE = 0,
+	TRACE_CALL_THROTTLE,
+	TRACE_CALL_PITCH,
+	TRACE_CALL_ROLL,
+	TRACE_CALL_YAW,
+	TRACE_CALL_RESET_CONTROL,
+	TRACE_CALL_AUX,
+	TRACE_CALL_CHANNEL_FRAME,
+	TRACE_CALL_PASSTHROUGH,
+	TRACE_CALL_START,
+	TRACE_CALL_STOP,
+
+	TRACE_MCPWM_GPIO_INIT = 32,
+	TRACE_MCPWM_INIT,
+	TRACE_MCPWM_START,
+	TRACE_MCPWM_STOP,
+	TRACE_MCPWM_SET_DUTY,
+	TRACE_MCPWM_SYNC_ENABLE,
+	TRACE_RMT_WRITE_ITEMS,
+	TRACE_MCPWM_SYNC_DISABLE,
+	TRACE_MCPWM_SYNC_OUTPUT,
+	TRACE_MCPWM_SET_FREQUENCY,
+	TRACE_MCPWM_CAPTURE_ENABLE,
+	TRACE_MCPWM_ISR_REGISTER,
+	TRACE_RMT_CONFIG,
+	TRACE_RMT_DRIVER_INSTALL,
+	TRACE_RMT_DRIVER_UNINSTALL,
+	TRACE_RMT_TX_STOP,
+	TRACE_RMT_SET_TX_LOOP_MODE,
+	TRACE_RMT_WAIT_TX_DONE,
+	TRACE_RMT_FILL_TX_ITEMS,
+	TRACE_RMT_TX_START
+} trace_call_id;
+
+/**
+ * @brief Whether an event starts a span, ends it, or stands alone
+ */
+typedef enum
+{
+	TRACE_PHASE_BEGIN = 'B',
+	TRACE_PHASE_END = 'E',
+	TRACE_PHASE_INSTANT = 'i'
+} trace_phase;
+
+/**
+ * @brief One recorded event
+ */
+typedef struct
+{
+	//Low 32 bits of the system clock in microseconds
+	uint32_t timestamp;
+
+	uint8_t type;
+	uint8_t phase;
+
+	//The trace_call_id or channel the event is about
+	uint16_t arg;
+
+	//The core the event was recorded on
+	uint8_t core;
+
+	//Event specific detail, such as a frame sequence number or a driver return value
+	uint32_t value;
+} trace_event_t;
+
+/**
+ * @brief Fixed size ring of trace events, safe to record into from any task
+ */
+class TraceRecorder
+{
+public:
+	/**
+	 * @brief Add an event to the ring, overwriting the oldest
+	 */
+	static void record(trace_event_type type, trace_phase phase, uint16_t arg, uint32_t value);
+
+	/**
+	 * @brief Record the end of a span with a call's return value and hand the value back
+	 */
+	static int end(trace_event_type type, uint16_t arg, int result) { record(type, TRACE_PHASE_END, arg, (uint32_t) result); return result; }
+
+	/**
+	 * @brief Write the recorded events oldest first as text lines for ProtocolTesting/trace_to_chrome.py, recording
+	 * is paused during the dump and an event still being written when it started is left out
+	 * 
+	 * @param writeLine Called with each null terminated line, without a newline
+	 */
+	static void dump(void (*writeLine)(const char * line));
+
+	/**
+	 * @brief Discard every recorded event
+	 */
+	static void clear();
+
+	/**
+	 * @brief Set the clock events are stamped with, FlightControlEmulator::setClock passes its clock on here
+	 * 
+	 * @param clock The clock to use, the system clock is used if null
+	 */
+	static void setClock(FlightClock * clock);
+};
+
+/**
+ * @brief Records the begin of a span on construction and its end on destruction
+ */
+class TraceScope
+{
+protected:
+	trace_event_type type;
+	uint16_t arg;
+
+public:
+	TraceScope(trace_event_type type, uint16_t arg) : type(type), arg(arg) { TraceRecorder::record(type, TRACE_PHASE_BEGIN, arg, 0); }
+
+	~TraceScope() { TraceRecorder::record(this->type, TRACE_PHASE_END, this->arg, 0); }
+};
+
+#ifdef FCE_TRACE_ENABLED
+#define FCE_TRACE_JOIN_(a, b) a##b
+#define FCE_TRACE_JOIN(a, b) FCE_TRACE_JOIN_(a, b)
+#define FCE_TRACE_INSTANT(type, arg, value) TraceRecorder::record(type, TRACE_PHASE_INSTANT, arg, value)
+#define FCE_TRACE_SCOPE(type, arg) TraceScope FCE_TRACE_JOIN(traceScope, __LINE__)(type, arg)
+#define FCE_TRACE_CALL(type, arg, expr) (TraceRecorder::record(type, TRACE_PHASE_BEGIN, arg, 0), TraceRecorder::end(type, arg, (expr)))
+#else
+#define FCE_TRACE_INSTANT(type, arg, value) ((void) 0)
+#define FCE_TRACE_SCOPE(type, arg) ((void) 0)
+#define FCE_TRACE_CALL(type, arg, expr) (expr)
+#endif
+
+#endif
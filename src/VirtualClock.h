@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2020 Lena Voytek
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef VIRTUALCLOCK_H
+#define VIRTUALCLOCK_H
+
+#include "FlightClock.h"
+
+/**
+ * @brief Deterministic clock for simulation, sleeping jumps straight to the requested time instead of waiting
+ */
+class VirtualClock : public FlightClock
+{
+protected:
+	//The simulated time
+	uint64_t currentTime;
+
+public:
+	/**
+	 * @brief Start the virtual clock at the given time
+	 * 
+	 * @param startMicros The initial time of the clock
+	 */
+	VirtualClock(uint64_t startMicros) : currentTime(startMicros) {}
+
+	/**
+	 * @brief Start the virtual clock at time zero
+	 */
+	VirtualClock() : VirtualClock(0) {}
+
+	uint64_t now() { return this->currentTime; }
+
+	void sleepUntil(uint64_t timeMicros);
+
+	/**
+	 * @brief Move the clock forward without anything waiting on it
+	 * 
+	 * @param durationMicros The number of microseconds to skip
+	 */
+	void advance(uint64_t durationMicros) { this->currentTime += durationMicros; }
+};
+
+#endif